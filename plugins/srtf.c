@@ -0,0 +1,114 @@
+/*
+ * srtf.c
+ *
+ * Priority-SRTF as a policy plugin: the built-in default, rewritten
+ * against scheduler_plugin.h. Runs with it match the built-in policy
+ * exactly, which makes it the reference for --plugin-bench.
+ *
+ * Each core's ready queue is a list sorted by priority, then remaining
+ * time, linked through the tasks' private slots.
+ *
+ */
+
+#include <stdlib.h>
+
+#include "scheduler_plugin.h"
+
+#define NEXT 0                          // Slot: next task in the core's queue
+#define AGE 1                           // Slot: ms waited since the last aging step
+
+typedef struct {
+    int cores;
+    SchedTask *head[];                  // Ready queue of each core
+} SrtfState;
+
+static inline SchedTask* next_of(const SchedTask *t) {
+    return (SchedTask *)t->slots[NEXT];
+}
+
+/**
+ * Insert behind every task that is at least as good: equal keys stay FIFO
+ */
+static void insert_sorted(SchedTask **head, SchedTask *t) {
+    SchedTask **link = head;
+    while (*link != NULL &&
+           (t->priority > (*link)->priority ||
+            (t->priority == (*link)->priority && t->remaining_time >= (*link)->remaining_time))) {
+        link = (SchedTask **)&(*link)->slots[NEXT];
+    }
+    t->slots[NEXT] = (uintptr_t)*link;
+    t->slots[AGE] = 0;
+    *link = t;
+}
+
+static void *srtf_init(int cores) {
+    SrtfState *s = calloc(1, sizeof(SrtfState) + sizeof(SchedTask *) * cores);
+    if (s != NULL) {
+        s->cores = cores;
+    }
+    return s;
+}
+
+static void srtf_fini(void *state) {
+    free(state);
+}
+
+static void srtf_enqueue(void *state, int core, SchedTask *task, int clock) {
+    (void)clock;
+    insert_sorted(&((SrtfState *)state)->head[core], task);
+}
+
+static SchedTask *srtf_pick_next(void *state, int core, int clock) {
+    (void)clock;
+    SrtfState *s = state;
+    SchedTask *t = s->head[core];
+    s->head[core] = next_of(t);
+    t->slots[NEXT] = 0;
+    return t;
+}
+
+/**
+ * Raise the priority of every waiting task by one per 100 ms, then re-sort
+ * As in the built-in queue, re-sorting a queue of two or more restarts the
+ * tasks' aging timers.
+ */
+static void srtf_on_tick(void *state, int clock, int elapsed) {
+    (void)clock;
+    SrtfState *s = state;
+    for (int c = 0; c < s->cores; c++) {
+        for (SchedTask *t = s->head[c]; t != NULL; t = next_of(t)) {
+            t->slots[AGE] += elapsed;
+            if (t->slots[AGE] >= 100) {
+                int steps = (int)(t->slots[AGE] / 100);
+                t->slots[AGE] %= 100;
+                if (t->priority > 0) {
+                    t->priority = t->priority > steps ? t->priority - steps : 0;
+                }
+            }
+        }
+        if (s->head[c] == NULL || next_of(s->head[c]) == NULL) {
+            continue;
+        }
+        SchedTask *t = s->head[c];
+        s->head[c] = NULL;
+        while (t != NULL) {
+            SchedTask *next = next_of(t);
+            insert_sorted(&s->head[c], t);
+            t = next;
+        }
+    }
+}
+
+static const SchedPlugin srtf_plugin = {
+    .abi_version = SCHED_PLUGIN_ABI_VERSION,
+    .name = "srtf",
+    .init = srtf_init,
+    .fini = srtf_fini,
+    .enqueue = srtf_enqueue,
+    .pick_next = srtf_pick_next,
+    .on_tick = srtf_on_tick,
+};
+
+const SchedPlugin *sched_plugin_entry(void) {
+    return &srtf_plugin;
+}
@@ -0,0 +1,84 @@
+/*
+ * wait_hist.c
+ *
+ * Example lifecycle hooks: counts every event and builds a log2 histogram
+ * of ready-queue waits, taken at dispatch. Load with --hooks.
+ *
+ */
+
+#include <stdio.h>
+
+#include "scheduler_plugin.h"
+
+#define BUCKETS 16                      // Waits of 0, 1, 2-3, 4-7, ... ms
+
+static const char *event_names[SCHED_NUM_HOOKS] = {
+    [SCHED_HOOK_ARRIVAL] = "arrival",
+    [SCHED_HOOK_DISPATCH] = "dispatch",
+    [SCHED_HOOK_BURST_END] = "burst_end",
+    [SCHED_HOOK_IO_START] = "io_start",
+    [SCHED_HOOK_IO_END] = "io_end",
+    [SCHED_HOOK_AGING] = "aging",
+    [SCHED_HOOK_TERMINATE] = "terminate",
+};
+
+// Parallel runs may call the hooks concurrently
+static long events[SCHED_NUM_HOOKS];
+static long waits[BUCKETS];
+
+static void count_event(SchedHookEvent event, const SchedTask *task, int clock, void *arg) {
+    (void)task;
+    (void)clock;
+    (void)arg;
+    __atomic_fetch_add(&events[event], 1, __ATOMIC_RELAXED);
+}
+
+static void record_wait(SchedHookEvent event, const SchedTask *task, int clock, void *arg) {
+    int wait = clock - task->ready_since;
+    int b = 0;
+    while (wait > 0 && b < BUCKETS - 1) {
+        wait >>= 1;
+        b++;
+    }
+    __atomic_fetch_add(&waits[b], 1, __ATOMIC_RELAXED);
+    count_event(event, task, clock, arg);
+}
+
+static int wait_hist_attach(SchedHookRegister register_hook) {
+    for (int e = 0; e < SCHED_NUM_HOOKS; e++) {
+        if (register_hook(e, e == SCHED_HOOK_DISPATCH ? record_wait : count_event, NULL) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void wait_hist_report(void) {
+    printf("\n=== Hook Report (wait_hist) ===\n");
+    for (int e = 0; e < SCHED_NUM_HOOKS; e++) {
+        printf("%-10s %10ld\n", event_names[e], events[e]);
+    }
+    printf("Ready wait at dispatch (ms):\n");
+    for (int b = 0; b < BUCKETS; b++) {
+        if (waits[b] == 0) {
+            continue;
+        }
+        long lo = b == 0 ? 0 : 1L << (b - 1);
+        if (b == BUCKETS - 1) {
+            printf("  %6ld+      %10ld\n", lo, waits[b]);
+        } else {
+            printf("  %6ld-%-6ld %10ld\n", lo, b == 0 ? 0 : (1L << b) - 1, waits[b]);
+        }
+    }
+}
+
+static const SchedHooks wait_hist = {
+    .abi_version = SCHED_HOOKS_ABI_VERSION,
+    .name = "wait_hist",
+    .attach = wait_hist_attach,
+    .report = wait_hist_report,
+};
+
+const SchedHooks *sched_hooks_entry(void) {
+    return &wait_hist;
+}
@@ -14,6 +14,26 @@
  * - Aging mechanism: priority decrements by 1 every 100ms in ready queue
  * - I/O management via separate pthread
  * - Non-preemptive execution
+ * - Virtual-time mode and parallel independent replications
+ * - Multiple cores with pluggable dispatch (RR, JSQ, power-of-d, LWL, SITA)
+ * - Gittins-index policy for unknown job sizes
+ * - cgroup-style CPU bandwidth groups (quota per period)
+ * - Shared resources with priority inheritance or ceiling protocols
+ * - Gang scheduling of multi-threaded jobs with EASY backfilling
+ * - Independently scheduled worker threads drawn from a per-run pool
+ * - Asynchronous I/O with a bounded outstanding depth per process
+ * - Cores going offline and online mid-run with bulk queue redistribution
+ * - Core idle states (C-states) with residency thresholds and wakeup latency
+ * - DVFS frequency levels with timer-driven governors and energy estimates
+ * - SMT sibling pairs that slow each other down when both are busy
+ * - Periodic and Poisson noise sources stealing CPU from running bursts
+ * - Working sets against host memory, with thrashing and memory-aware admission
+ * - Multi-node clusters behind a global dispatcher, synchronized by time windows
+ * - MultiQueue relaxed concurrent priority queue with a rank-error benchmark
+ * - Locked, prefaulted memory and optional SCHED_FIFO for real-time runs
+ * - Ready-queue policies loaded from shared objects through a stable C ABI
+ * - Lifecycle hooks for custom metrics, free when none are registered
+ * - Streaming workload characterization in bounded memory
  * 
  */
 
@@ -25,8 +45,22 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <limits.h>
+#include <stdint.h>
 #include <sys/time.h>
 #include <stdarg.h>
+#include <math.h>
+#include <getopt.h>
+#include <glob.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sched.h>
+#include <stddef.h>
+#include <dlfcn.h>
+
+#include "scheduler_plugin.h"
 
 /* Explicit declaration for usleep to avoid warnings with -std=gnu99 */
 int usleep(unsigned int usec);
@@ -35,6 +69,24 @@ int usleep(unsigned int usec);
  * DATA STRUCTURES
  * ============================================================================ */
 
+#define MAX_PRIORITY 10              // Lowest priority level (0 is highest)
+#define NUM_PRIORITIES (MAX_PRIORITY + 1)
+#define MAX_CORES 64                 // Upper bound for --cores
+#define MAX_CORE_EVENTS 32           // Upper bound for --offline windows
+#define MAX_CSTATES 8                // Idle states in --cstates
+#define CSTATE_NAME_LEN 8
+#define MAX_EXIT_LATENCY 1000        // Largest exit latency (ms), bounds the histogram
+#define MAX_FREQ_LEVELS 16           // Frequency levels in --freqs
+#define ONDEMAND_UP_THRESHOLD 0.8    // Window utilization that selects the top frequency
+#define MAX_NOISE_SOURCES 8          // Upper bound for --noise
+#define MAX_BURST_NOISE 1000         // Per-burst stolen time histogram bound (ms)
+#define GITTINS_BUCKETS 4096         // Attained-service buckets of the Gittins table
+#define MAX_GROUPS 16                // Upper bound for --cgroup
+#define GROUP_NAME_LEN 32
+#define MAX_RESOURCES 64             // Distinct res= names over all workloads
+#define RESOURCE_NAME_LEN 32
+#define AIO_RING_SIZE 8              // Largest aio= depth (inline completion ring)
+
 /**
  * Process State Enumeration
  * Represents the current state of a process in the system
@@ -44,6 +96,7 @@ typedef enum {
     STATE_READY,        // Process is in ready queue waiting for CPU
     STATE_RUNNING,      // Process is currently executing on CPU
     STATE_WAITING,      // Process is blocked waiting for I/O
+    STATE_BLOCKED,      // Process is waiting for a resource held by another
     STATE_TERMINATED    // Process has completed execution
 } ProcessState;
 
@@ -65,6 +118,36 @@ typedef struct Process {
     int time_in_ready_queue;        // Time spent in ready queue (for aging)
     int io_completion_time;         // When current I/O will complete
     int has_arrived;                // Flag: has process arrived yet?
+    int arrival_clock;              // Clock tick at which the process arrived
+    int ready_since;                // Clock tick of last entry into ready queue
+    int first_dispatch_clock;       // Clock tick of first dispatch (-1 if none)
+    int completion_clock;           // Clock tick of termination (-1 if none)
+    int total_wait;                 // Total time spent in ready queue (ms)
+    double rank;                    // Heap rank when last made ready (Gittins index)
+    int group;                      // CPU bandwidth group, -1 if none
+    int resource;                   // Resource locked by each critical section, -1 if none
+    int hold_bursts;                // Bursts per critical section
+    int held_bursts_left;           // Bursts left while holding the resource (0: not held)
+    int boosted_from;               // Priority before an inheritance/ceiling boost, aged
+                                    // while boosted; -1 if none
+    int blocked_since;              // Clock at which it blocked on the resource
+    int blocked_by_lower;           // Blocked behind a lower-priority holder?
+    int core;                       // Core whose ready queue holds it, -1 if none
+    int heap_pos;                   // Index in the ready or waiter heap holding it
+    int threads;                    // Threads that must run together (gang size)
+    int gang_leader;                // Core that completes the gang's burst
+    int workers;                    // Independent threads of the process (1 if none)
+    int tid;                        // Thread number within its process (0: main thread)
+    int live_threads;               // Threads of the process not yet terminated
+    struct Process *owner;          // Process a worker thread belongs to, NULL for main threads
+    int aio_depth;                  // Outstanding asynchronous I/Os allowed (0: blocking I/O)
+    int aio_head;                   // Oldest entry of aio_ring
+    int aio_count;                  // I/Os outstanding
+    int aio_ring[AIO_RING_SIZE];    // Completion clocks of outstanding I/Os, oldest first
+    int aio_wait_every;             // Bursts between explicit waits (0: only before exit)
+    int aio_bursts;                 // Bursts since the last explicit wait
+    int mem;                        // Working set (MB), shared by the process's threads
+    SchedTask task;                 // What a --policy-plugin sees of this process
     
     struct Process *next;           // Pointer to next process in queue
 } Process;
@@ -79,26 +162,534 @@ typedef struct {
     int size;
 } Queue;
 
+/**
+ * Timer Event Kinds
+ * Future events that fire at a given clock tick
+ */
+typedef enum {
+    TIMER_ARRIVAL,                  // Closed-system user submits its next job
+    TIMER_GROUP_REFRESH,            // Throttled group's next period begins
+    TIMER_CORE_OFFLINE,             // Core id stops taking work
+    TIMER_CORE_ONLINE,              // Core id comes back
+    TIMER_GOVERNOR,                 // DVFS governor re-evaluates every core
+    TIMER_NOISE                     // Noise source id / MAX_CORES hits core id % MAX_CORES
+} TimerKind;
+
+typedef struct {
+    int when;                       // Clock tick at which the event fires
+    int kind;                       // TimerKind
+    int id;                         // Process index or other event argument
+    unsigned seq;                   // Insertion order, breaks ties
+} Timer;
+
+typedef struct {
+    Timer *items;
+    int size;
+    int capacity;
+    unsigned next_seq;
+} TimerHeap;
+
+/**
+ * xoshiro256** PRNG state
+ * jump() advances by 2^128 draws, giving non-overlapping streams
+ */
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+/**
+ * Ready-queue ordering policies
+ */
+typedef enum {
+    POLICY_SRTF,                    // Priority, then shortest remaining time (needs sizes)
+    POLICY_GITTINS,                 // Priority, then Gittins index of attained service
+    POLICY_FCFS,                    // Priority, then time of entry into the ready queue
+    NUM_SCHED_POLICIES
+} SchedPolicy;
+
+/**
+ * Gittins indices over attained service, precomputed from a job-size
+ * distribution; bucket j covers attained service [j * width, (j + 1) * width)
+ */
+typedef struct {
+    int width;                      // Attained service per bucket (ms)
+    int buckets;                    // Buckets in use
+    double index[GITTINS_BUCKETS];  // Completions per ms of service invested
+} GittinsTable;
+
+/**
+ * CPU Core
+ * Every core has its own ready queue. Arrivals and I/O returns are placed
+ * on a core by the dispatch policy, using the cached aggregates below.
+ */
+typedef struct {
+    Queue ready_queue;              // Ready queue of this core (srtf)
+    Process **heap;                 // Ready heap of this core (gittins, fcfs)
+    int heap_size;
+    int plugin_size;                // Processes queued in the policy plugin
+    Process *running_process;       // Process currently on this core
+    int running_until;              // When current process will finish its burst (idle since, if none)
+    int burst_start;                // When the current burst began executing, after any wakeup
+    int level;                      // DVFS frequency level (0: fastest)
+    int burst_level;                // Level the current burst runs at
+    long window_mark;               // Executed busy time at the last governor evaluation
+    int burst_wall;                 // Length of the current burst running alone (ms)
+    int burst_work;                 // CPU time the current burst delivers (ms)
+    double work_left;               // Part of burst_wall still to run, as of work_mark
+    int work_mark;
+    double rate;                    // Progress per ms: 1 alone, 1 / --smt next to a busy sibling
+    int corun_since;                // Even core of a pair: both busy since, -1 if not
+    int burst_noise;                // Time stolen from the current burst by noise (ms)
+    long busy_time;                 // CPU busy time of this core (ms)
+    long queued_work;               // Remaining CPU time of queued processes (ms)
+    long key;                       // Dispatch key: queue length, or clock at which work drains
+    int offline;                    // Taken offline by --offline
+} Core;
+
+/**
+ * Core Idle State (--cstates NAME:RESIDENCY/EXIT)
+ * An idle core enters the state once it has been idle for residency ms;
+ * leaving it delays the next dispatch by exit_latency ms.
+ */
+typedef struct {
+    char name[CSTATE_NAME_LEN];
+    int residency;
+    int exit_latency;
+} CState;
+
+/**
+ * Noise Source (--noise periodic|poisson:INTERVAL/DURATION[@CORE])
+ * Every hit steals duration ms from the burst running on the core.
+ */
+typedef struct {
+    int poisson;                    // Exponential gaps with mean interval, else fixed period
+    double interval;                // Period or mean gap between hits (ms)
+    int duration;                   // CPU time stolen per hit (ms)
+    int core;                       // Core hit, -1 for every core
+} NoiseSource;
+
+/**
+ * Core Offline Window (--offline CORE@FROM[:TO])
+ */
+typedef struct {
+    int core;
+    int from;                       // Clock at which the core goes offline
+    int to;                         // Clock at which it comes back, -1 for never
+} CoreEvent;
+
+/**
+ * Stretch of a run with a constant number of online cores
+ */
+typedef struct {
+    int start;                      // Clock at which the stretch began
+    int online;                     // Online cores during the stretch
+    int completed_before;           // Processes terminated before it began
+    int moved;                      // Processes preempted or redistributed at its start
+} CapacitySegment;
+
+/**
+ * Dispatch policies, choosing the core an arriving process joins
+ */
+typedef enum {
+    DISPATCH_RR,                    // Round-robin over cores
+    DISPATCH_JSQ,                   // Join the shortest queue
+    DISPATCH_POD,                   // Shortest of d randomly sampled queues
+    DISPATCH_LWL,                   // Least work left
+    DISPATCH_SITA,                  // Size-interval task assignment
+    NUM_DISPATCH_POLICIES
+} DispatchPolicy;
+
+/**
+ * SMT-aware placement: how ties between equally loaded cores are broken
+ */
+typedef enum {
+    SMT_PLACE_NONE,                 // Lowest core index
+    SMT_PLACE_SPREAD,               // Prefer a core whose sibling is idle
+    SMT_PLACE_PACK,                 // Prefer a core whose sibling is busy
+    NUM_SMT_PLACEMENTS
+} SmtPlacement;
+
+/**
+ * CPU bandwidth group, like cgroup cpu.max: the group's processes may run
+ * for quota ms in every period ms, summed over all cores
+ */
+typedef struct {
+    char name[GROUP_NAME_LEN];
+    int quota;                      // CPU time per period (ms)
+    int period;                     // Period length (ms)
+} GroupConfig;
+
+/**
+ * Run-time state of one bandwidth group
+ */
+typedef struct {
+    long used;                      // Runtime charged to the current period (ms)
+    int period_index;               // Period the usage belongs to
+    int throttled;                  // Processes are held out of the ready queues
+    int throttled_since;            // Clock at which the throttle began
+    Queue held;                     // Ready processes set aside while throttled
+    long runtime;                   // Total runtime charged (ms)
+    long throttle_count;
+    long throttled_time;            // Total time spent throttled (ms)
+    int max_throttle;               // Longest single throttle (ms)
+} GroupState;
+
+/**
+ * DVFS governors
+ */
+typedef enum {
+    GOVERNOR_PERFORMANCE,           // Always the fastest level
+    GOVERNOR_POWERSAVE,             // Always the slowest level
+    GOVERNOR_ONDEMAND,              // Follows each core's utilization over a window
+    NUM_GOVERNORS
+} Governor;
+
+/**
+ * Locking protocols for shared resources
+ */
+typedef enum {
+    LOCKS_NONE,                     // Plain mutexes: holders keep their own priority
+    LOCKS_INHERIT,                  // Holder inherits its highest-priority waiter's priority
+    LOCKS_CEILING,                  // Holder runs at the resource's priority ceiling
+    NUM_LOCK_PROTOCOLS
+} LockProtocol;
+
+/**
+ * Run-time state of one shared resource
+ */
+typedef struct {
+    Process *holder;                // Current holder, NULL if free
+    Process **waiters;              // Heap of blocked processes, highest priority first
+    int waiter_count;
+    int users;                      // Processes in the workload that use the resource
+    int ceiling;                    // Highest priority (lowest number) among users
+    long acquisitions;
+    long contended;                 // Acquisitions that had to wait
+} ResourceState;
+
+/**
+ * Steady-state metric identifiers
+ * Each metric is fed one observation per relevant event
+ */
+typedef enum {
+    METRIC_WAIT,                    // Ready-queue wait per dispatch (ms)
+    METRIC_TURNAROUND,              // Arrival to termination per process (ms)
+    NUM_STEADY_METRICS
+} SteadyMetricId;
+
+/**
+ * Running statistics for one steady-state metric
+ * Observations are folded into MSER-5 batch means as they arrive
+ */
+typedef struct {
+    double *batch_means;            // Completed MSER-5 batch means
+    int batches;                    // Number of completed batches
+    int capacity;                   // Allocated size of batch_means
+    double partial_sum;             // Sum of the current incomplete batch
+    int partial_count;              // Observations in the current batch
+    long observations;              // Total observations recorded
+    int next_check;                 // Batch count at which to re-test convergence
+    int truncation;                 // Warm-up batches deleted by MSER
+    double mean;                    // Steady-state mean estimate
+    double half_width;              // 95% CI half-width of the mean
+    int valid;                      // Estimate available?
+} SteadyMetric;
+
+/**
+ * Simulation Context
+ * Holds all state of one scheduler run, so that several runs can proceed
+ * independently in the same process (e.g. parallel replications)
+ */
+typedef struct {
+    Process *processes;             // All processes, sorted by arrival
+    int total_processes;            // Total number of processes
+    int next_arrival;               // Index of the next process to arrive
+    int terminated_count;           // Number of terminated processes
+    
+    int current_clock;              // Simulation clock (ms)
+    volatile int all_terminated;    // Flag: run finished?
+    
+    Core cores[MAX_CORES];          // Per-core ready queues and running processes
+    int num_cores;
+    int ready_total;                // Ready processes over all cores
+    Queue waiting_queue;            // Waiting queue (I/O)
+    pthread_mutex_t queue_mutex;    // Protects ready and waiting queues
+    pthread_mutex_t clock_mutex;    // Protects the clock
+    
+    int realtime;                   // 1: 1ms wall-clock ticks + I/O thread
+    int quiet;                      // 1: suppress per-event output
+    
+    int last_aging_check;           // Last time we checked aging
+    long busy_time;                 // Total CPU busy time over all cores (ms)
+    long wait_by_priority[NUM_PRIORITIES];      // Ready-queue wait per original priority
+    long dispatches_by_priority[NUM_PRIORITIES];
+    
+    SteadyMetric steady[NUM_STEADY_METRICS];
+    int steady_done;                // Steady-state CIs reached the target width
+    int steady_stopped_early;       // Run ended by the convergence test?
+    int stop_clock;                 // Clock at which the run ended
+    
+    int checkpoint_interval;        // Checkpoint every N ms (0 = off, virtual time only)
+    int next_checkpoint;            // Clock of the next checkpoint
+    struct CheckpointLog *checkpoints;          // Record checkpoints here, if set
+    struct ConvergenceTarget *converge;         // Stop once state matches, if set
+    int converged;                  // Run ended on a baseline state match
+    
+    TimerHeap timers;               // Pending timer events
+    int end_clock;                  // Stop at this clock (0 = run to completion)
+    
+    int closed;                     // Closed system: users resubmit after thinking
+    double think_mean;              // Mean exponential think time (ms)
+    Rng rng;                        // Think-time stream of this run
+    long jobs_completed;            // Closed-system job completions
+    double response_sum;            // Sum of job response times (ms)
+    double response_sq_sum;         // Sum of squared response times
+    int response_max;               // Largest job response time (ms)
+    
+    int dispatch;                   // DispatchPolicy
+    int choices;                    // Cores sampled by power-of-d
+    Rng dispatch_rng;               // Power-of-d samples, apart from the workload's draws
+    Rng noise_rng;                  // Poisson noise gaps, apart from both
+    int rr_next;                    // Next core for round-robin
+    int lwl_clock;                  // Clock of the idle cores' lwl keys
+    int tree_leaves;                // Leaves of core_tree (power of two)
+    int core_tree[2 * MAX_CORES];   // Tournament tree: core with the smallest key
+    int sita_cutoffs[MAX_CORES];    // Largest job size (ms) sent to each core
+    
+    int policy;                     // SchedPolicy of the ready queues
+    const GittinsTable *gittins;    // Index table in use
+    GittinsTable *own_gittins;      // Table learned from this workload, if any
+    
+    GroupState groups[MAX_GROUPS];  // Indexed like group_configs
+    int num_groups;
+    
+    ResourceState resources[MAX_RESOURCES];     // Indexed like resource_names
+    int lock_protocol;              // LockProtocol
+    long lock_blocks[NUM_PRIORITIES];           // Resource waits per original priority
+    long lock_blocked_time[NUM_PRIORITIES];     // Time blocked on resources (ms)
+    long inversion_time[NUM_PRIORITIES];        // Of which behind lower-priority holders
+    int max_blocked[NUM_PRIORITIES];            // Longest single resource wait (ms)
+    
+    Queue gang_ready[MAX_CORES + 1];            // Ready gang jobs by thread count
+    uint64_t gang_classes;          // Bit k - 1 set: gang_ready[k] is non-empty
+    int gang_waiting;               // Ready gang jobs
+    int gang_backfill;              // EASY backfilling, else strict reservation
+    int gang_reserved;              // A blocked gang job holds a reservation this tick
+    int shadow_clock;               // When the reserved job's cores will be free
+    int shadow_extra;               // Cores free at shadow_clock beyond the reservation
+    int gang_jobs[MAX_CORES + 1];   // Gang jobs in the workload by thread count
+    long gang_dispatches[MAX_CORES + 1];
+    long gang_wait[MAX_CORES + 1];  // Ready-queue wait of gang bursts (ms)
+    long backfilled_gang;           // Gang bursts started ahead of the reservation
+    long backfilled_single;         // Single-thread bursts started ahead of it
+    int fragment_cores;             // Idle cores while gang jobs wait, since fragment_since
+    int fragment_since;
+    long fragmented_time;           // Idle core-ms while gang jobs waited
+    
+    Process *thread_pool;           // Slots for worker threads, allocated once per run
+    Process *free_threads;          // Unused slots, linked through next
+    int pool_size;
+    int live_workers;               // Worker threads currently in use
+    int peak_workers;
+    long threads_spawned;
+    
+    Queue drained;                  // Finished processes whose last async I/Os completed
+    Queue inbox;                    // Arrivals routed here by a cluster dispatcher, in order
+    int offline_cores;
+    CapacitySegment segments[2 * MAX_CORE_EVENTS + 1];
+    int segment_count;
+    
+    long cstate_residency[MAX_CSTATES];         // Idle core-ms spent in each state
+    long cstate_wakeups[MAX_CSTATES];           // Dispatches that woke a core from it
+    long shallow_idle;                          // Idle core-ms before the first state
+    long wake_hist[MAX_EXIT_LATENCY + 1];       // Dispatch wakeup latency (ms)
+    long wakeups;                               // Dispatches onto an idle core
+    
+    long level_busy[MAX_FREQ_LEVELS];           // Busy core-ms at each frequency level
+    long freq_changes;
+    int periodic_timers;                        // Self re-arming timers (governor, noise)
+    
+    double smt_factor;              // Slowdown with both siblings busy, 0: no SMT
+    int smt_place;
+    long smt_stretch;               // Burst time added by sibling interference (ms)
+    long corun_time;                // Time both siblings of a pair were busy, summed (ms)
+    
+    long noise_hits;                // Noise hits on a running burst
+    long noise_idle_hits;           // ...and on an idle core (absorbed)
+    long noise_stolen;              // Core-ms stolen from bursts
+    long noise_busy;                // Busy core-ms spent running noise (gangs: every core)
+    long burst_noise_hist[MAX_BURST_NOISE + 1];  // Stolen time per completed burst (ms)
+    long noisy_bursts;              // Completed bursts, counted while noise is enabled
+    
+    Queue mem_waiting;              // Arrivals held until their working set fits
+    long resident;                  // Working sets of admitted, unfinished processes (MB)
+    long peak_resident;
+    int resident_mark;              // Clock of the last change to resident
+    double resident_integral;       // MB-ms, for the time-weighted mean
+    long overcommit_time;           // Time with resident above capacity (ms)
+    long mem_holds;                 // Arrivals held by admission
+    long mem_hold_time;             // Time they were held (ms)
+    double slowdown_sum;            // Thrashing slowdowns of dispatched bursts
+    long slowed_bursts;             // Dispatched bursts while memory is modelled
+    long aio_issued;                // Asynchronous I/Os issued
+    long aio_overlapped;            // ...of which the process kept running
+    long aio_stalls;                // Bursts that blocked on a full ring
+    long aio_stall_time;            // Time blocked on full rings (ms)
+    long aio_drains;                // Processes that waited for I/O before exiting
+    long aio_drain_time;
+    long aio_waits;                 // Explicit waits requested by wait=
+    long aio_wait_time;             // Time they blocked beyond any full-ring stall (ms)
+    
+    int lock_memory;                // --lock-memory: mlockall and prefault before the run
+    int fifo_priority;              // --sched-fifo priority, 0: default policy
+    int memory_locked;
+    int mlock_error;                // errno of a failed mlockall
+    int fifo_error;                 // Error of a refused SCHED_FIFO request
+    long prefaulted;                // Bytes of tables touched before the run
+    long minor_faults;              // Faults taken by the process during the run
+    long major_faults;
+    
+    const SchedPlugin *plugin;      // --policy-plugin, NULL: built-in policy
+    void *plugin_state;             // From the plugin's init, one per run
+    long plugin_calls;              // Callbacks made into the plugin
+} SimContext;
+
+/**
+ * Run Summary
+ * Aggregate metrics of one finished run
+ */
+typedef enum {
+    SUMMARY_COMPLETED,              // Processes terminated
+    SUMMARY_MAKESPAN,               // Clock at end of run (ms)
+    SUMMARY_THROUGHPUT,             // Terminations per second
+    SUMMARY_UTILIZATION,            // CPU busy fraction
+    SUMMARY_MEAN_WAIT,              // Mean total ready-queue wait (ms)
+    SUMMARY_MEAN_RESPONSE,          // Mean arrival-to-first-dispatch (ms)
+    SUMMARY_MEAN_TURNAROUND,        // Mean arrival-to-termination (ms)
+    SUMMARY_P95_TURNAROUND,         // 95th percentile turnaround (ms)
+    SUMMARY_MAX_TURNAROUND,         // Maximum turnaround (ms)
+    NUM_SUMMARY_METRICS
+} SummaryMetricId;
+
+typedef struct {
+    double values[NUM_SUMMARY_METRICS];
+} RunSummary;
+
 /* ============================================================================
  * GLOBAL VARIABLES
  * ============================================================================ */
 
-Process *all_processes = NULL;      // Array of all processes
-int total_processes = 0;             // Total number of processes
-int current_clock = 0;               // Global clock (ms)
-int all_terminated = 0;              // Flag: all processes terminated?
+pthread_mutex_t output_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int steady_state_enabled = 0;        // --steady-state given?
+double ci_target_width = 0.05;       // Target relative CI half-width
+unsigned steady_metric_mask = 1u << METRIC_WAIT;
 
-Queue ready_queue;                   // Ready queue
-Queue waiting_queue;                 // Waiting queue (I/O)
+int core_count = 1;                  // --cores
+int dispatch_policy = DISPATCH_JSQ;  // --dispatch
+int dispatch_choices = 2;            // --choices
+double smt_factor = 0.0;             // --smt
+int smt_place = SMT_PLACE_NONE;      // --smt-place
+int sched_policy = POLICY_SRTF;      // --policy
+GittinsTable *gittins_prior = NULL;  // --size-prior, shared by every run
 
-pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t clock_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t output_mutex = PTHREAD_MUTEX_INITIALIZER;
+GroupConfig group_configs[MAX_GROUPS];   // --cgroup, read-only once parsing is done
+int group_count = 0;
+CoreEvent core_events[MAX_CORE_EVENTS];  // --offline
+int core_event_count = 0;
+CState cstates[MAX_CSTATES];             // --cstates, shallowest first
+int cstate_count = 0;
+NoiseSource noise_sources[MAX_NOISE_SOURCES];  // --noise
+int noise_count = 0;
+long memory_capacity = 0;                // --memory (MB), 0: no memory model
+double thrash_penalty = 10.0;            // --thrash-penalty
+int mem_admission = 0;                   // --mem-admit
+int freq_levels[MAX_FREQ_LEVELS];        // --freqs (MHz), fastest first
+int freq_count = 0;
+int governor = GOVERNOR_PERFORMANCE;     // --governor
+int governor_window = 20;                // --governor-window (ms)
+double active_watts = 10.0;              // --power: core power at the top frequency
+double idle_watts = 1.0;                 // ...and when idle
+
+char resource_names[MAX_RESOURCES][RESOURCE_NAME_LEN];  // Interned res= names
+int resource_count = 0;
+pthread_mutex_t resource_mutex = PTHREAD_MUTEX_INITIALIZER;     // Protects the names
+int lock_protocol = LOCKS_INHERIT;   // --locks
+int gang_backfill = 0;               // --backfill
+int cluster_nodes = 0;               // --nodes, 0: a single machine
+int cluster_placement = 0;           // --placement, index into placements[] (jsq)
+int cluster_window = 10;             // --sync-window (ms)
+int lock_memory = 0;                 // --lock-memory
+int fifo_priority = 0;               // --sched-fifo
+const SchedPlugin *policy_plugin = NULL;     // --policy-plugin, shared by every run
+
+const char *lock_protocol_names[NUM_LOCK_PROTOCOLS] = {
+    [LOCKS_NONE] = "none",
+    [LOCKS_INHERIT] = "inherit",
+    [LOCKS_CEILING] = "ceiling",
+};
+
+const char *smt_place_names[NUM_SMT_PLACEMENTS] = {
+    [SMT_PLACE_NONE] = "none",
+    [SMT_PLACE_SPREAD] = "spread",
+    [SMT_PLACE_PACK] = "pack",
+};
+
+const char *governor_names[NUM_GOVERNORS] = {
+    [GOVERNOR_PERFORMANCE] = "performance",
+    [GOVERNOR_POWERSAVE] = "powersave",
+    [GOVERNOR_ONDEMAND] = "ondemand",
+};
+
+const char *sched_policy_names[NUM_SCHED_POLICIES] = {
+    [POLICY_SRTF] = "srtf",
+    [POLICY_GITTINS] = "gittins",
+    [POLICY_FCFS] = "fcfs",
+};
+
+const char *dispatch_policy_names[NUM_DISPATCH_POLICIES] = {
+    [DISPATCH_RR] = "rr",
+    [DISPATCH_JSQ] = "jsq",
+    [DISPATCH_POD] = "pod",
+    [DISPATCH_LWL] = "lwl",
+    [DISPATCH_SITA] = "sita",
+};
+
+const char *steady_metric_names[NUM_STEADY_METRICS] = {
+    [METRIC_WAIT] = "wait",
+    [METRIC_TURNAROUND] = "turnaround",
+};
+
+const char *summary_metric_names[NUM_SUMMARY_METRICS] = {
+    [SUMMARY_COMPLETED] = "completed",
+    [SUMMARY_MAKESPAN] = "makespan_ms",
+    [SUMMARY_THROUGHPUT] = "throughput_per_s",
+    [SUMMARY_UTILIZATION] = "cpu_utilization",
+    [SUMMARY_MEAN_WAIT] = "mean_wait_ms",
+    [SUMMARY_MEAN_RESPONSE] = "mean_response_ms",
+    [SUMMARY_MEAN_TURNAROUND] = "mean_turnaround_ms",
+    [SUMMARY_P95_TURNAROUND] = "p95_turnaround_ms",
+    [SUMMARY_MAX_TURNAROUND] = "max_turnaround_ms",
+};
 
 /* ============================================================================
  * QUEUE OPERATIONS
  * ============================================================================ */
 
+/**
+ * PCB of a schedulable entity: a worker thread's process, else itself
+ */
+static inline Process* pcb_of(Process *p) {
+    return p->owner != NULL ? p->owner : p;
+}
+
+/**
+ * Scheduling priority; worker threads share their process's priority
+ */
+static inline int sched_priority(const Process *p) {
+    return p->owner != NULL ? p->owner->priority : p->priority;
+}
+
 /**
  * Initialize a queue
  */
@@ -169,13 +760,15 @@ void insert_ready_queue(Queue *q, Process *p) {
     // Find correct position based on Priority-SRTF
     Process *current = q->head;
     Process *prev = NULL;
+    int priority = sched_priority(p);
     
     while (current != NULL) {
         // Compare: first by priority, then by remaining_time
         int should_insert = 0;
-        if (p->priority < current->priority) {
+        int current_priority = sched_priority(current);
+        if (priority < current_priority) {
             should_insert = 1;  // Higher priority (lower number)
-        } else if (p->priority == current->priority && 
+        } else if (priority == current_priority &&
                    p->remaining_time < current->remaining_time) {
             should_insert = 1;  // Same priority, shorter remaining time
         }
@@ -239,408 +832,7722 @@ void remove_from_queue(Queue *q, Process *p) {
     }
 }
 
-/* ============================================================================
- * INPUT PARSING
- * ============================================================================ */
-
 /**
- * Parse input file and load all processes
- * File format: [pid] [arrival_time] [cpu_execution_time] [interval_time] [io_time] [priority]
+ * Re-sort ready queue after aging updates
+ * Remove all processes and re-insert them based on new priorities
  */
-int parse_input_file(const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        perror("Error opening input file");
-        return -1;
+void resort_ready_queue(Queue *ready_queue) {
+    if (ready_queue->size <= 1) {
+        return;  // No need to sort
     }
     
-    // Count number of processes
-    total_processes = 0;
-    char line[256];
-    while (fgets(line, sizeof(line), file) != NULL) {
-        if (strlen(line) > 1) {  // Skip empty lines
-            total_processes++;
-        }
-    }
+    // Collect all processes
+    Process *processes[ready_queue->size];
+    int count = 0;
     
-    if (total_processes == 0) {
-        fprintf(stderr, "Error: No processes found in input file\n");
-        fclose(file);
-        return -1;
+    while (!is_empty(ready_queue)) {
+        processes[count++] = dequeue(ready_queue);
     }
     
-    // Allocate memory for processes
-    all_processes = (Process *)malloc(sizeof(Process) * total_processes);
-    if (all_processes == NULL) {
-        perror("Error allocating memory for processes");
-        fclose(file);
-        return -1;
+    // Re-insert with new priorities
+    for (int i = 0; i < count; i++) {
+        insert_ready_queue(ready_queue, processes[i]);
     }
-    
-    // Read processes
-    rewind(file);
-    int idx = 0;
-    while (fgets(line, sizeof(line), file) != NULL && idx < total_processes) {
-        if (strlen(line) <= 1) continue;  // Skip empty lines
-        
-        int pid, arrival, cpu_time, interval, io, priority;
-        if (sscanf(line, "%d %d %d %d %d %d", 
-                   &pid, &arrival, &cpu_time, &interval, &io, &priority) != 6) {
-            fprintf(stderr, "Error: Invalid format in input file at line %d\n", idx + 1);
-            free(all_processes);
-            fclose(file);
-            return -1;
+}
+
+/**
+ * Ready-heap order: priority first, then the higher Gittins index;
+ * equal keys keep the order in which processes became ready
+ */
+static inline int heap_before(const Process *a, const Process *b) {
+    if (sched_priority(a) != sched_priority(b)) {
+        return sched_priority(a) < sched_priority(b);
+    }
+    if (a->rank != b->rank) {
+        return a->rank > b->rank;
+    }
+    if (a->ready_since != b->ready_since) {
+        return a->ready_since < b->ready_since;
+    }
+    return a->pid < b->pid;
+}
+
+static void heap_sift_down(Process **heap, int size, int i) {
+    for (;;) {
+        int best = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < size && heap_before(heap[l], heap[best])) {
+            best = l;
         }
-        
-        // Initialize process
-        all_processes[idx].pid = pid;
-        all_processes[idx].arrival_time = arrival;
-        all_processes[idx].cpu_execution_time = cpu_time;
-        all_processes[idx].remaining_time = cpu_time;
-        all_processes[idx].interval_time = interval;
-        all_processes[idx].io_time = io;
-        all_processes[idx].priority = priority;
-        all_processes[idx].original_priority = priority;
-        all_processes[idx].state = STATE_NEW;
-        all_processes[idx].time_in_ready_queue = 0;
-        all_processes[idx].io_completion_time = 0;
-        all_processes[idx].has_arrived = 0;
-        all_processes[idx].next = NULL;
-        
-        idx++;
+        if (r < size && heap_before(heap[r], heap[best])) {
+            best = r;
+        }
+        if (best == i) {
+            return;
+        }
+        Process *tmp = heap[i];
+        heap[i] = heap[best];
+        heap[best] = tmp;
+        heap[i]->heap_pos = i;
+        heap[best]->heap_pos = best;
+        i = best;
     }
-    
-    fclose(file);
-    return 0;
 }
 
-/* ============================================================================
- * OUTPUT FUNCTIONS
- * ============================================================================ */
+/**
+ * Move heap[i] towards the root after its key improved: O(log n)
+ */
+void heap_sift_up(Process **heap, int i) {
+    Process *p = heap[i];
+    while (i > 0 && heap_before(p, heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        heap[i]->heap_pos = i;
+        i = (i - 1) / 2;
+    }
+    heap[i] = p;
+    p->heap_pos = i;
+}
 
 /**
- * Thread-safe print function
- * Ensures atomic output to prevent interleaved messages
+ * Push a process onto a ready heap (capacity is reserved by the caller)
  */
-void safe_print(const char *format, ...) {
-    pthread_mutex_lock(&output_mutex);
-    va_list args;
-    va_start(args, format);
-    vprintf(format, args);
-    va_end(args);
-    fflush(stdout);
-    pthread_mutex_unlock(&output_mutex);
+void heap_push(Process **heap, int *size, Process *p) {
+    heap[*size] = p;
+    heap_sift_up(heap, (*size)++);
 }
 
-/* ============================================================================
- * I/O MANAGER THREAD
- * ============================================================================ */
+/**
+ * Pop the first process of a non-empty ready heap
+ */
+Process* heap_pop(Process **heap, int *size) {
+    Process *top = heap[0];
+    heap[0] = heap[--(*size)];
+    heap[0]->heap_pos = 0;
+    heap_sift_down(heap, *size, 0);
+    top->heap_pos = -1;
+    return top;
+}
 
 /**
- * I/O Manager Thread Function
- * 
- * Manages processes in the waiting queue. Checks each millisecond if any
- * process has completed its I/O operation and moves it back to ready queue.
+ * Restore heap order after keys changed in place (aging)
  */
-void* io_manager_thread(void *arg) {
-    (void)arg;  // Unused parameter
-    
-    while (!all_terminated) {
-        usleep(1000);  // Sleep for 1ms
-        
-        pthread_mutex_lock(&clock_mutex);
-        int clock = current_clock;
-        pthread_mutex_unlock(&clock_mutex);
-        
-        pthread_mutex_lock(&queue_mutex);
-        
-        // Check all processes in waiting queue
-        Process *current = waiting_queue.head;
-        Process *prev = NULL;
-        
-        while (current != NULL) {
-            if (clock >= current->io_completion_time) {
-                // I/O completed
-                Process *completed = current;
-                current = current->next;
-                
-                // Remove from waiting queue
-                if (prev == NULL) {
-                    waiting_queue.head = completed->next;
-                    if (waiting_queue.head == NULL) {
-                        waiting_queue.tail = NULL;
-                    }
-                } else {
-                    prev->next = completed->next;
-                    if (completed->next == NULL) {
-                        waiting_queue.tail = prev;
-                    }
-                }
-                waiting_queue.size--;
-                
-                completed->next = NULL;
-                completed->state = STATE_READY;
-                
-                // Output: I/O finished
-                pthread_mutex_lock(&output_mutex);
-                printf("[Clock: %d] PID %d finished I/O\n", clock, completed->pid);
-                fflush(stdout);
-                pthread_mutex_unlock(&output_mutex);
-                
-                // Move to ready queue
-                insert_ready_queue(&ready_queue, completed);
-                
-                pthread_mutex_lock(&output_mutex);
-                printf("[Clock: %d] PID %d moved to READY queue\n", clock, completed->pid);
-                fflush(stdout);
-                pthread_mutex_unlock(&output_mutex);
-                
-            } else {
-                prev = current;
-                current = current->next;
-            }
-        }
-        
-        pthread_mutex_unlock(&queue_mutex);
+void heap_rebuild(Process **heap, int size) {
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        heap_sift_down(heap, size, i);
     }
-    
-    return NULL;
 }
 
 /* ============================================================================
- * AGING MECHANISM
+ * TIMER EVENTS
  * ============================================================================ */
 
 /**
- * Update aging for all processes in ready queue
- * Decrement priority by 1 for every 100ms spent in ready queue
- * Priority cannot go below 0
+ * Binary min-heap of future events ordered by (when, insertion order)
  */
-void update_aging(int elapsed_ms) {
-    Process *current = ready_queue.head;
-    
-    while (current != NULL) {
-        current->time_in_ready_queue += elapsed_ms;
-        
-        // Check if 100ms threshold reached
-        if (current->time_in_ready_queue >= 100) {
-            int aging_steps = current->time_in_ready_queue / 100;
-            current->time_in_ready_queue %= 100;  // Keep remainder
-            
-            // Decrement priority (but not below 0)
-            if (current->priority > 0) {
-                current->priority -= aging_steps;
-                if (current->priority < 0) {
-                    current->priority = 0;
-                }
-            }
-        }
-        
-        current = current->next;
+void timer_heap_free(TimerHeap *h) {
+    free(h->items);
+    h->items = NULL;
+    h->size = 0;
+    h->capacity = 0;
+}
+
+static int timer_before(const Timer *a, const Timer *b) {
+    return a->when < b->when || (a->when == b->when && a->seq < b->seq);
+}
+
+/**
+ * Grow the heap to hold at least capacity events; returns -1 on allocation failure
+ */
+int timer_reserve(TimerHeap *h, int capacity) {
+    if (capacity <= h->capacity) {
+        return 0;
+    }
+    Timer *grown = realloc(h->items, sizeof(Timer) * capacity);
+    if (grown == NULL) {
+        perror("Error allocating timer heap");
+        return -1;
     }
+    h->items = grown;
+    h->capacity = capacity;
+    return 0;
 }
 
 /**
- * Re-sort ready queue after aging updates
- * Remove all processes and re-insert them based on new priorities
+ * Schedule an event; returns -1 on allocation failure
  */
-void resort_ready_queue() {
-    if (ready_queue.size <= 1) {
-        return;  // No need to sort
+int timer_push(TimerHeap *h, int when, int kind, int id) {
+    if (h->size == h->capacity &&
+        timer_reserve(h, h->capacity ? h->capacity * 2 : 64) != 0) {
+        return -1;
     }
     
-    // Collect all processes
-    Process *processes[ready_queue.size];
-    int count = 0;
+    Timer t = { when, kind, id, h->next_seq++ };
+    int i = h->size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!timer_before(&t, &h->items[parent])) {
+            break;
+        }
+        h->items[i] = h->items[parent];
+        i = parent;
+    }
+    h->items[i] = t;
+    return 0;
+}
+
+/**
+ * Remove and return the earliest event (heap must not be empty)
+ */
+Timer timer_pop(TimerHeap *h) {
+    Timer top = h->items[0];
+    Timer last = h->items[--h->size];
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= h->size) {
+            break;
+        }
+        if (child + 1 < h->size && timer_before(&h->items[child + 1], &h->items[child])) {
+            child++;
+        }
+        if (!timer_before(&h->items[child], &last)) {
+            break;
+        }
+        h->items[i] = h->items[child];
+        i = child;
+    }
+    if (h->size > 0) {
+        h->items[i] = last;
+    }
+    return top;
+}
+
+/**
+ * Time of the earliest event, INT_MAX if none
+ */
+static inline int timer_next(const TimerHeap *h) {
+    return h->size > 0 ? h->items[0].when : INT_MAX;
+}
+
+/* ============================================================================
+ * RANDOM NUMBER GENERATION
+ * ============================================================================ */
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Seed the generator from a single 64-bit value via splitmix64
+ */
+void rng_seed(Rng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        rng->s[i] = z ^ (z >> 31);
+    }
+}
+
+/**
+ * Next 64-bit output
+ */
+uint64_t rng_next(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    
+    return result;
+}
+
+/**
+ * Advance the stream by the distance encoded in jump
+ */
+static void rng_jump_by(Rng *rng, const uint64_t jump[4]) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & (1ULL << b)) {
+                s0 ^= rng->s[0];
+                s1 ^= rng->s[1];
+                s2 ^= rng->s[2];
+                s3 ^= rng->s[3];
+            }
+            rng_next(rng);
+        }
+    }
+    rng->s[0] = s0;
+    rng->s[1] = s1;
+    rng->s[2] = s2;
+    rng->s[3] = s3;
+}
+
+/**
+ * Advance the stream by 2^128 draws: one stream per run
+ */
+void rng_jump(Rng *rng) {
+    static const uint64_t jump[] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    rng_jump_by(rng, jump);
+}
+
+/**
+ * Advance the stream by 2^192 draws: sub-streams of one run that never meet
+ * the 2^128-spaced streams of other runs
+ */
+void rng_long_jump(Rng *rng) {
+    static const uint64_t jump[] = {
+        0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+        0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+    };
+    rng_jump_by(rng, jump);
+}
+
+/**
+ * Uniform double in [0, 1)
+ */
+double rng_uniform(Rng *rng) {
+    return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * Exponentially distributed value with the given mean
+ */
+double rng_exponential(Rng *rng, double mean) {
+    return -mean * log(1.0 - rng_uniform(rng));
+}
+
+/* ============================================================================
+ * GITTINS INDEX
+ * ============================================================================ */
+
+static int compare_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_long(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Precompute Gittins indices from a sample of job sizes (sorted in place)
+ *
+ * For attained service a the index is
+ *     max over b > a of  P(S <= b | S > a) / E[min(S, b) - a | S > a],
+ * the completion probability per unit of service if the job is run up to b.
+ * Only b on a bucket boundary holding sizes can be the maximum, so each
+ * bucket costs one pass over the size histogram.
+ */
+int gittins_build(GittinsTable *table, int *sizes, int n) {
+    memset(table, 0, sizeof(*table));
+    if (n == 0) {
+        table->width = 1;
+        table->buckets = 1;
+        return 0;
+    }
+    
+    qsort(sizes, n, sizeof(int), compare_int);
+    int max_size = sizes[n - 1] > 1 ? sizes[n - 1] : 1;
+    table->width = (max_size + GITTINS_BUCKETS - 1) / GITTINS_BUCKETS;
+    table->buckets = (max_size + table->width - 1) / table->width;
+    int w = table->width;
+    
+    // Histogram of sizes rounded up to bucket boundaries
+    long *count = calloc(table->buckets + 1, sizeof(long));
+    if (count == NULL) {
+        perror("Error allocating Gittins table");
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        int b = (sizes[i] + w - 1) / w;
+        count[b < 0 ? 0 : b]++;
+    }
+    
+    long survivors = n;
+    for (int j = 0; j < table->buckets; j++) {
+        survivors -= count[j];              // Jobs of size <= j * w are done
+        double best = 0.0;
+        long done = 0;
+        double invested = 0.0;              // Service of jobs finishing by b
+        for (int b = j + 1; b <= table->buckets && survivors > 0; b++) {
+            if (count[b] == 0) {
+                continue;
+            }
+            done += count[b];
+            invested += (double)count[b] * (b - j) * w;
+            double ratio = done / (invested + (double)(survivors - done) * (b - j) * w);
+            if (ratio > best) {
+                best = ratio;
+            }
+        }
+        // Beyond the largest sample the index of the last bucket carries over
+        table->index[j] = survivors > 0 || j == 0 ? best : table->index[j - 1];
+    }
+    
+    free(count);
+    return 0;
+}
+
+/**
+ * Index of a process given the CPU time it has received so far
+ */
+static inline double gittins_index(const GittinsTable *table, int attained) {
+    int j = attained / table->width;
+    return table->index[j < table->buckets ? j : table->buckets - 1];
+}
+
+/**
+ * Learn the index table from the sizes of the loaded workload
+ */
+GittinsTable* gittins_from_processes(const Process *processes, int n) {
+    GittinsTable *table = malloc(sizeof(GittinsTable));
+    int *sizes = malloc(sizeof(int) * (n > 0 ? n : 1));
+    if (table == NULL || sizes == NULL) {
+        perror("Error allocating Gittins table");
+        free(table);
+        free(sizes);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        sizes[i] = processes[i].cpu_execution_time;
+    }
+    if (gittins_build(table, sizes, n) != 0) {
+        free(table);
+        table = NULL;
+    }
+    free(sizes);
+    return table;
+}
+
+/* ============================================================================
+ * POLICY PLUGINS
+ * ============================================================================ */
+
+/**
+ * Load a ready-queue policy from a shared object (see scheduler_plugin.h)
+ * The object stays loaded for the rest of the program. Returns NULL with a
+ * message if it cannot be used.
+ */
+const SchedPlugin* plugin_load(const char *path) {
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        fprintf(stderr, "Error: Cannot load policy plugin: %s\n", dlerror());
+        return NULL;
+    }
+    
+    // Go through a union: ISO C has no cast from void * to a function pointer
+    union {
+        void *symbol;
+        SchedPluginEntry entry;
+    } entry;
+    entry.symbol = dlsym(handle, SCHED_PLUGIN_ENTRY);
+    const SchedPlugin *plugin = entry.symbol != NULL ? entry.entry() : NULL;
+    if (plugin == NULL) {
+        fprintf(stderr, "Error: %s does not export %s()\n", path, SCHED_PLUGIN_ENTRY);
+    } else if (plugin->abi_version != SCHED_PLUGIN_ABI_VERSION) {
+        fprintf(stderr, "Error: %s was built for plugin ABI %u, this scheduler uses %d\n",
+                path, plugin->abi_version, SCHED_PLUGIN_ABI_VERSION);
+        plugin = NULL;
+    } else if (plugin->init == NULL || plugin->enqueue == NULL || plugin->pick_next == NULL) {
+        fprintf(stderr, "Error: %s lacks init, enqueue or pick_next\n", path);
+        plugin = NULL;
+    }
+    if (plugin == NULL) {
+        dlclose(handle);
+    }
+    return plugin;
+}
+
+/**
+ * Copy the ABI-visible fields of a process into a task view (not the slots)
+ */
+static inline void task_fill(SchedTask *t, const Process *p) {
+    t->pid = p->pid;
+    t->priority = sched_priority(p);
+    t->original_priority = p->original_priority;
+    t->cpu_execution_time = p->cpu_execution_time;
+    t->remaining_time = p->remaining_time;
+    t->interval_time = p->interval_time;
+    t->io_time = p->io_time;
+    t->arrival_clock = p->arrival_clock;
+    t->ready_since = p->ready_since;
+    t->total_wait = p->total_wait;
+}
+
+/**
+ * Refresh the plugin's view of a process before handing it over
+ */
+static inline SchedTask* plugin_task(Process *p) {
+    task_fill(&p->task, p);
+    return &p->task;
+}
+
+/**
+ * PCB holding a task the plugin returned
+ */
+static inline Process* plugin_process(SchedTask *t) {
+    return (Process *)((char *)t - offsetof(Process, task));
+}
+
+static void plugin_block(SimContext *ctx, Process *p, int clock) {
+    if (ctx->plugin != NULL && ctx->plugin->on_block != NULL) {
+        ctx->plugin_calls++;
+        ctx->plugin->on_block(ctx->plugin_state, plugin_task(p), clock);
+    }
+}
+
+static void plugin_exit(SimContext *ctx, Process *p, int clock) {
+    if (ctx->plugin != NULL && ctx->plugin->on_exit != NULL) {
+        ctx->plugin_calls++;
+        ctx->plugin->on_exit(ctx->plugin_state, plugin_task(p), clock);
+    }
+}
+
+/* ============================================================================
+ * LIFECYCLE HOOKS
+ * ============================================================================ */
+
+#define MAX_HOOKS 16                    // Per event
+#define MAX_HOOK_LIBRARIES 8
+
+typedef struct {
+    SchedHook fn;
+    void *arg;
+} HookEntry;
+
+HookEntry hooks[SCHED_NUM_HOOKS][MAX_HOOKS];    // Read-only once runs start
+int hook_count[SCHED_NUM_HOOKS];
+unsigned hook_mask = 0;                         // Bit e set: event e has hooks
+const SchedHooks *hook_libraries[MAX_HOOK_LIBRARIES];  // --hooks, in load order
+int hook_library_count = 0;
+
+/**
+ * Register fn for event; returns -1 if the event has MAX_HOOKS already
+ */
+int hook_register(SchedHookEvent event, SchedHook fn, void *arg) {
+    if ((unsigned)event >= SCHED_NUM_HOOKS || fn == NULL || hook_count[event] == MAX_HOOKS) {
+        return -1;
+    }
+    hooks[event][hook_count[event]++] = (HookEntry){ fn, arg };
+    hook_mask |= 1u << event;
+    return 0;
+}
+
+static void hook_call(SchedHookEvent event, const Process *p, int clock) {
+    SchedTask view = p->task;
+    task_fill(&view, p);
+    for (int i = 0; i < hook_count[event]; i++) {
+        hooks[event][i].fn(event, &view, clock, hooks[event][i].arg);
+    }
+}
+
+/**
+ * Fire an event: one mask test when nothing is registered for it
+ */
+static inline void hook_fire(SchedHookEvent event, const Process *p, int clock) {
+    if (hook_mask & (1u << event)) {
+        hook_call(event, p, clock);
+    }
+}
+
+/**
+ * Load a hook library and let it register its hooks
+ * Returns -1 with a message if it cannot be used.
+ */
+int hooks_load(const char *path) {
+    if (hook_library_count == MAX_HOOK_LIBRARIES) {
+        fprintf(stderr, "Error: At most %d --hooks libraries\n", MAX_HOOK_LIBRARIES);
+        return -1;
+    }
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        fprintf(stderr, "Error: Cannot load hooks: %s\n", dlerror());
+        return -1;
+    }
+    
+    union {
+        void *symbol;
+        SchedHooksEntry entry;
+    } entry;
+    entry.symbol = dlsym(handle, SCHED_HOOKS_ENTRY);
+    const SchedHooks *lib = entry.symbol != NULL ? entry.entry() : NULL;
+    if (lib == NULL) {
+        fprintf(stderr, "Error: %s does not export %s()\n", path, SCHED_HOOKS_ENTRY);
+    } else if (lib->abi_version != SCHED_HOOKS_ABI_VERSION) {
+        fprintf(stderr, "Error: %s was built for hooks ABI %u, this scheduler uses %d\n",
+                path, lib->abi_version, SCHED_HOOKS_ABI_VERSION);
+        lib = NULL;
+    } else if (lib->attach == NULL) {
+        fprintf(stderr, "Error: %s lacks attach\n", path);
+        lib = NULL;
+    } else if (lib->attach(hook_register) != 0) {
+        fprintf(stderr, "Error: Hooks %s failed to attach\n", lib->name);
+        lib = NULL;
+    }
+    if (lib == NULL) {
+        dlclose(handle);
+        return -1;
+    }
+    hook_libraries[hook_library_count++] = lib;
+    return 0;
+}
+
+/**
+ * Let every hook library print its results
+ */
+void hooks_report(void) {
+    for (int i = 0; i < hook_library_count; i++) {
+        if (hook_libraries[i]->report != NULL) {
+            fflush(stdout);
+            hook_libraries[i]->report();
+        }
+    }
+    fflush(stdout);
+}
+
+/* ============================================================================
+ * CORES AND DISPATCH
+ * ============================================================================ */
+
+/**
+ * Does core a beat core b? Smaller key wins, ties go to the lower index.
+ */
+static inline int core_beats(const SimContext *ctx, int a, int b) {
+    long ka = ctx->cores[a].key, kb = ctx->cores[b].key;
+    return ka < kb || (ka == kb && a < b);
+}
+
+/**
+ * Replay the matches from core c's leaf up to the root: O(log cores)
+ */
+static void core_tree_update(SimContext *ctx, int c) {
+    int *tree = ctx->core_tree;
+    int n = ctx->tree_leaves + c;
+    
+    for (n /= 2; n >= 1; n /= 2) {
+        int l = tree[2 * n], r = tree[2 * n + 1];
+        tree[n] = (r < 0 || (l >= 0 && core_beats(ctx, l, r))) ? l : r;
+    }
+}
+
+/**
+ * Build the tournament tree over all cores; padding leaves are -1
+ */
+void core_tree_build(SimContext *ctx) {
+    ctx->tree_leaves = 1;
+    while (ctx->tree_leaves < ctx->num_cores) {
+        ctx->tree_leaves *= 2;
+    }
+    for (int i = 0; i < 2 * ctx->tree_leaves; i++) {
+        ctx->core_tree[i] = -1;
+    }
+    for (int c = 0; c < ctx->num_cores; c++) {
+        ctx->core_tree[ctx->tree_leaves + c] = c;
+    }
+    for (int n = ctx->tree_leaves - 1; n >= 1; n--) {
+        int l = ctx->core_tree[2 * n], r = ctx->core_tree[2 * n + 1];
+        ctx->core_tree[n] = (r < 0 || (l >= 0 && core_beats(ctx, l, r))) ? l : r;
+    }
+}
+
+/**
+ * Processes waiting on a core (only one of the list and heap is in use)
+ */
+static inline int core_ready_count(const Core *core) {
+    return core->ready_queue.size + core->heap_size + core->plugin_size;
+}
+
+/**
+ * SMT sibling of a core (cores 2k and 2k + 1 share a physical core), or NULL
+ */
+static inline Core* smt_sibling(SimContext *ctx, const Core *core) {
+    int c = (int)(core - ctx->cores) ^ 1;
+    return ctx->smt_factor > 0 && c < ctx->num_cores ? &ctx->cores[c] : NULL;
+}
+
+/**
+ * Recompute a core's dispatch key after its queue or CPU changed
+ */
+void core_refresh(SimContext *ctx, Core *core) {
+    if (core->offline) {
+        core->key = LONG_MAX;
+    } else if (ctx->dispatch == DISPATCH_LWL) {
+        // Committed work drains at the end of the burst plus the queued CPU time
+        long start = core->running_process != NULL ? core->running_until : ctx->current_clock;
+        core->key = start + core->queued_work;
+    } else {
+        core->key = core_ready_count(core) + (core->running_process != NULL);
+    }
+    if (ctx->smt_place != SMT_PLACE_NONE && !core->offline) {
+        const Core *sibling = smt_sibling(ctx, core);
+        int sibling_busy = sibling != NULL && sibling->running_process != NULL;
+        core->key = 2 * core->key + (ctx->smt_place == SMT_PLACE_SPREAD ? sibling_busy : !sibling_busy);
+    }
+    if (ctx->dispatch == DISPATCH_JSQ || ctx->dispatch == DISPATCH_LWL) {
+        core_tree_update(ctx, (int)(core - ctx->cores));
+    }
+}
+
+/**
+ * Insert a process into a core's ready queue, keeping the aggregates current
+ */
+void core_enqueue(SimContext *ctx, Core *core, Process *p) {
+    p->core = (int)(core - ctx->cores);
+    if (ctx->plugin != NULL) {
+        ctx->plugin_calls++;
+        ctx->plugin->enqueue(ctx->plugin_state, p->core, plugin_task(p), ctx->current_clock);
+        core->plugin_size++;
+    } else if (ctx->policy != POLICY_SRTF) {
+        p->time_in_ready_queue = 0;
+        p->rank = ctx->policy == POLICY_GITTINS
+                  ? gittins_index(ctx->gittins, p->cpu_execution_time - p->remaining_time) : 0.0;
+        heap_push(core->heap, &core->heap_size, p);
+    } else {
+        insert_ready_queue(&core->ready_queue, p);
+    }
+    core->queued_work += p->remaining_time;
+    ctx->ready_total++;
+    core_refresh(ctx, core);
+}
+
+/**
+ * Take the head of a core's ready queue; the caller refreshes the key
+ * once the process is on the CPU
+ */
+Process* core_dequeue(SimContext *ctx, Core *core) {
+    Process *p;
+    if (ctx->plugin != NULL) {
+        ctx->plugin_calls++;
+        p = plugin_process(ctx->plugin->pick_next(ctx->plugin_state, (int)(core - ctx->cores),
+                                                  ctx->current_clock));
+        pcb_of(p)->priority = p->task.priority;
+        core->plugin_size--;
+    } else {
+        p = ctx->policy != POLICY_SRTF ? heap_pop(core->heap, &core->heap_size)
+                                       : dequeue(&core->ready_queue);
+    }
+    p->core = -1;
+    core->queued_work -= p->remaining_time;
+    ctx->ready_total--;
+    return p;
+}
+
+/**
+ * Recompute every cached aggregate from the queues (after a restore)
+ */
+void core_rebuild(SimContext *ctx) {
+    ctx->ready_total = 0;
+    for (int c = 0; c < ctx->num_cores; c++) {
+        Core *core = &ctx->cores[c];
+        core->queued_work = 0;
+        for (Process *p = core->ready_queue.head; p != NULL; p = p->next) {
+            core->queued_work += p->remaining_time;
+        }
+        for (int i = 0; i < core->heap_size; i++) {
+            core->queued_work += core->heap[i]->remaining_time;
+        }
+        ctx->ready_total += core_ready_count(core);
+        core_refresh(ctx, core);
+    }
+    core_tree_build(ctx);
+}
+
+/**
+ * Restore the order of every ready queue and resource wait heap after a
+ * process's priority changed: its worker threads may sit in any of them
+ */
+void resort_all_queues(SimContext *ctx) {
+    for (int c = 0; c < ctx->num_cores; c++) {
+        Core *core = &ctx->cores[c];
+        if (ctx->policy != POLICY_SRTF) {
+            heap_rebuild(core->heap, core->heap_size);
+        } else {
+            resort_ready_queue(&core->ready_queue);
+        }
+    }
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        heap_rebuild(ctx->resources[r].waiters, ctx->resources[r].waiter_count);
+    }
+}
+
+/**
+ * SITA-E cutoffs: sort the job sizes and split them into one interval per
+ * core so that every interval carries an equal share of the total CPU time
+ * Returns -1 if the sizes cannot be sorted.
+ */
+int sita_setup(SimContext *ctx) {
+    int n = ctx->total_processes;
+    long *sizes = malloc(sizeof(long) * (n > 0 ? n : 1));
+    if (sizes == NULL) {
+        perror("Error allocating SITA cutoffs");
+        return -1;
+    }
+    
+    long total = 0;
+    for (int i = 0; i < n; i++) {
+        sizes[i] = ctx->processes[i].cpu_execution_time;
+        total += sizes[i];
+    }
+    qsort(sizes, n, sizeof(long), compare_long);
+    
+    long cumulative = 0;
+    int core = 0;
+    for (int i = 0; i < n && core < ctx->num_cores - 1; i++) {
+        cumulative += sizes[i];
+        while (core < ctx->num_cores - 1 &&
+               cumulative * ctx->num_cores >= total * (core + 1)) {
+            ctx->sita_cutoffs[core++] = (int)sizes[i];
+        }
+    }
+    while (core < ctx->num_cores) {
+        ctx->sita_cutoffs[core++] = INT_MAX;
+    }
+    
+    free(sizes);
+    return 0;
+}
+
+/**
+ * Heap policies: pick the Gittins table and reserve room for every process
+ * and worker thread in each core's heap, so enqueueing never allocates
+ * Returns -1 if the policy cannot be set up.
+ */
+int heap_policy_setup(SimContext *ctx) {
+    if (ctx->policy == POLICY_GITTINS && ctx->gittins == NULL) {
+        ctx->own_gittins = gittins_from_processes(ctx->processes, ctx->total_processes);
+        ctx->gittins = ctx->own_gittins;
+        if (ctx->gittins == NULL) {
+            return -1;
+        }
+    }
+    for (int c = 0; c < ctx->num_cores; c++) {
+        if (ctx->cores[c].heap == NULL) {
+            ctx->cores[c].heap = malloc(sizeof(Process *) *
+                                        (ctx->total_processes + ctx->pool_size + 1));
+            if (ctx->cores[c].heap == NULL) {
+                perror("Error allocating ready heap");
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Prepare the ready-queue and dispatch policies for the loaded workload
+ * Falls back to srtf and jsq if a policy cannot be set up.
+ */
+void dispatch_setup(SimContext *ctx) {
+    for (int i = 0; i < ctx->total_processes; i++) {
+        if (ctx->processes[i].threads > 1) {
+            ctx->gang_jobs[ctx->processes[i].threads]++;
+        }
+    }
+    if (ctx->policy != POLICY_SRTF && heap_policy_setup(ctx) != 0) {
+        ctx->policy = POLICY_SRTF;
+    }
+    if (ctx->dispatch == DISPATCH_SITA && sita_setup(ctx) != 0) {
+        ctx->dispatch = DISPATCH_JSQ;
+    }
+    core_rebuild(ctx);
+}
+
+/**
+ * An idle core's lwl key starts its queued work at the clock of its last
+ * refresh; bring those keys up to the current clock, once per tick
+ */
+static void lwl_refresh_idle(SimContext *ctx) {
+    if (ctx->lwl_clock == ctx->current_clock) {
+        return;
+    }
+    ctx->lwl_clock = ctx->current_clock;
+    for (int c = 0; c < ctx->num_cores; c++) {
+        if (ctx->cores[c].running_process == NULL) {
+            core_refresh(ctx, &ctx->cores[c]);
+        }
+    }
+}
+
+/**
+ * Choose the core an arriving or I/O-returning process joins
+ * O(1) for rr, O(d) for pod and O(log cores) for jsq and sita; lwl adds
+ * O(cores) on the first dispatch of a tick to refresh the idle cores.
+ */
+Core* choose_core(SimContext *ctx, const Process *p) {
+    int n = ctx->num_cores;
+    if (n == 1) {
+        return &ctx->cores[0];
+    }
+    
+    int c = 0;
+    switch (ctx->dispatch) {
+        case DISPATCH_RR:
+            c = ctx->rr_next;
+            ctx->rr_next = (c + 1) % n;
+            break;
+        case DISPATCH_LWL:
+            lwl_refresh_idle(ctx);
+            c = ctx->core_tree[1];
+            break;
+        case DISPATCH_JSQ:
+            c = ctx->core_tree[1];
+            break;
+        case DISPATCH_POD:
+            c = (int)(rng_next(&ctx->dispatch_rng) % n);
+            for (int i = 1; i < ctx->choices; i++) {
+                int other = (int)(rng_next(&ctx->dispatch_rng) % n);
+                if (core_beats(ctx, other, c)) {
+                    c = other;
+                }
+            }
+            break;
+        case DISPATCH_SITA: {
+            // First core whose cutoff admits the job size
+            int lo = 0, hi = n - 1;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (p->cpu_execution_time <= ctx->sita_cutoffs[mid]) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+            c = lo;
+            break;
+        }
+    }
+    // Offline cores take no work: move on to the next online core
+    while (ctx->offline_cores > 0 && ctx->cores[c].offline) {
+        c = (c + 1) % n;
+    }
+    return &ctx->cores[c];
+}
+
+/**
+ * Parse a dispatch policy list ("jsq,pod" or "all") into a bit mask
+ * Returns 0 on an unknown name.
+ */
+unsigned parse_dispatch_policies(const char *list) {
+    if (strcmp(list, "all") == 0) {
+        return (1u << NUM_DISPATCH_POLICIES) - 1;
+    }
+    
+    unsigned mask = 0;
+    const char *c = list;
+    while (*c) {
+        size_t len = strcspn(c, ",");
+        int found = 0;
+        for (int i = 0; i < NUM_DISPATCH_POLICIES; i++) {
+            if (strlen(dispatch_policy_names[i]) == len &&
+                strncmp(c, dispatch_policy_names[i], len) == 0) {
+                mask |= 1u << i;
+                found = 1;
+            }
+        }
+        if (!found) {
+            return 0;
+        }
+        c += len;
+        if (*c == ',') {
+            c++;
+        }
+    }
+    return mask;
+}
+
+/**
+ * Parse an --offline window "CORE@FROM" or "CORE@FROM:TO" (ms)
+ */
+int parse_core_event(const char *spec) {
+    char *end;
+    long core = strtol(spec, &end, 10);
+    if (end == spec || *end != '@') {
+        return -1;
+    }
+    const char *from_text = end + 1;
+    long from = strtol(from_text, &end, 10);
+    long to = -1;
+    if (end == from_text) {
+        return -1;
+    }
+    if (*end == ':') {
+        const char *to_text = end + 1;
+        to = strtol(to_text, &end, 10);
+        if (end == to_text || to <= from) {
+            return -1;
+        }
+    }
+    if (*end != '\0' || core < 0 || core >= MAX_CORES || from < 1 || from > INT_MAX ||
+        to > INT_MAX || core_event_count == MAX_CORE_EVENTS) {
+        return -1;
+    }
+    CoreEvent *e = &core_events[core_event_count++];
+    e->core = (int)core;
+    e->from = (int)from;
+    e->to = (int)to;
+    return 0;
+}
+
+/* ============================================================================
+ * SIMULATION CONTEXT
+ * ============================================================================ */
+
+/**
+ * Initialize a simulation context (processes are loaded separately)
+ */
+void sim_init(SimContext *ctx, int realtime, int quiet) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->num_cores = core_count;
+    ctx->dispatch = dispatch_policy;
+    ctx->choices = dispatch_choices;
+    ctx->smt_factor = smt_factor;
+    ctx->smt_place = smt_place;
+    ctx->policy = sched_policy;
+    ctx->plugin = policy_plugin;
+    ctx->gittins = gittins_prior;
+    ctx->num_groups = group_count;
+    for (int g = 0; g < ctx->num_groups; g++) {
+        init_queue(&ctx->groups[g].held);
+    }
+    for (int k = 0; k <= MAX_CORES; k++) {
+        init_queue(&ctx->gang_ready[k]);
+    }
+    ctx->gang_backfill = gang_backfill;
+    for (int c = 0; c < ctx->num_cores; c++) {
+        init_queue(&ctx->cores[c].ready_queue);
+    }
+    core_tree_build(ctx);
+    init_queue(&ctx->waiting_queue);
+    init_queue(&ctx->drained);
+    init_queue(&ctx->inbox);
+    init_queue(&ctx->mem_waiting);
+    pthread_mutex_init(&ctx->queue_mutex, NULL);
+    pthread_mutex_init(&ctx->clock_mutex, NULL);
+    ctx->realtime = realtime;
+    ctx->quiet = quiet;
+    rng_seed(&ctx->rng, 1);
+}
+
+/**
+ * Release all resources owned by a simulation context
+ */
+void sim_destroy(SimContext *ctx) {
+    for (int i = 0; i < NUM_STEADY_METRICS; i++) {
+        free(ctx->steady[i].batch_means);
+        ctx->steady[i].batch_means = NULL;
+    }
+    free(ctx->processes);
+    ctx->processes = NULL;
+    for (int c = 0; c < ctx->num_cores; c++) {
+        free(ctx->cores[c].heap);
+        ctx->cores[c].heap = NULL;
+    }
+    free(ctx->own_gittins);
+    ctx->own_gittins = NULL;
+    free(ctx->thread_pool);
+    ctx->thread_pool = NULL;
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        free(ctx->resources[r].waiters);
+        ctx->resources[r].waiters = NULL;
+    }
+    if (ctx->plugin_state != NULL && ctx->plugin->fini != NULL) {
+        ctx->plugin->fini(ctx->plugin_state);
+    }
+    ctx->plugin_state = NULL;
+    timer_heap_free(&ctx->timers);
+    pthread_mutex_destroy(&ctx->queue_mutex);
+    pthread_mutex_destroy(&ctx->clock_mutex);
+}
+
+/**
+ * Initialize the PCB of a freshly loaded process
+ */
+void init_process(Process *p, int pid, int arrival, int cpu_time,
+                  int interval, int io, int priority) {
+    p->pid = pid;
+    p->arrival_time = arrival;
+    p->cpu_execution_time = cpu_time;
+    p->remaining_time = cpu_time;
+    p->interval_time = interval;
+    p->io_time = io;
+    p->priority = priority;
+    p->original_priority = priority;
+    memset(&p->task, 0, sizeof(p->task));
+    p->state = STATE_NEW;
+    p->time_in_ready_queue = 0;
+    p->io_completion_time = 0;
+    p->has_arrived = 0;
+    p->arrival_clock = 0;
+    p->ready_since = 0;
+    p->first_dispatch_clock = -1;
+    p->completion_clock = -1;
+    p->total_wait = 0;
+    p->rank = 0.0;
+    p->group = -1;
+    p->resource = -1;
+    p->hold_bursts = 0;
+    p->held_bursts_left = 0;
+    p->boosted_from = -1;
+    p->blocked_since = 0;
+    p->blocked_by_lower = 0;
+    p->core = -1;
+    p->heap_pos = -1;
+    p->threads = 1;
+    p->gang_leader = -1;
+    p->workers = 1;
+    p->tid = 0;
+    p->live_threads = 1;
+    p->owner = NULL;
+    p->aio_depth = 0;
+    p->aio_head = 0;
+    p->aio_count = 0;
+    p->aio_wait_every = 0;
+    p->aio_bursts = 0;
+    p->mem = 0;
+    p->next = NULL;
+}
+
+/**
+ * Clamp a priority into the 0..MAX_PRIORITY statistics classes
+ */
+static inline int priority_class(int priority) {
+    return priority < 0 ? 0 : (priority > MAX_PRIORITY ? MAX_PRIORITY : priority);
+}
+
+/**
+ * Effective arrival tick: the clock starts at 1, so earlier arrivals
+ * are all admitted on the first tick
+ */
+static int effective_arrival(const Process *p) {
+    return p->arrival_time < 1 ? 1 : p->arrival_time;
+}
+
+static int compare_arrival(const void *a, const void *b) {
+    const Process *pa = *(Process * const *)a;
+    const Process *pb = *(Process * const *)b;
+    int ta = effective_arrival(pa), tb = effective_arrival(pb);
+    if (ta != tb) {
+        return ta < tb ? -1 : 1;
+    }
+    return pa < pb ? -1 : (pa > pb);  // Keep input order for equal arrivals
+}
+
+/**
+ * Sort processes by arrival so the scheduler admits them with a cursor
+ * instead of scanning every process on every tick
+ */
+int sort_by_arrival(SimContext *ctx) {
+    int n = ctx->total_processes;
+    Process **order = malloc(sizeof(Process *) * n);
+    Process *sorted = malloc(sizeof(Process) * n);
+    if (order == NULL || sorted == NULL) {
+        perror("Error allocating memory for arrival order");
+        free(order);
+        free(sorted);
+        return -1;
+    }
+    
+    for (int i = 0; i < n; i++) {
+        order[i] = &ctx->processes[i];
+    }
+    qsort(order, n, sizeof(Process *), compare_arrival);
+    for (int i = 0; i < n; i++) {
+        sorted[i] = *order[i];
+    }
+    
+    free(order);
+    free(ctx->processes);
+    ctx->processes = sorted;
+    ctx->next_arrival = 0;
+    return 0;
+}
+
+/* ============================================================================
+ * INPUT PARSING
+ * ============================================================================ */
+
+/**
+ * Index of a configured bandwidth group, or -1
+ */
+int group_lookup(const char *name, size_t len) {
+    for (int g = 0; g < group_count; g++) {
+        if (strlen(group_configs[g].name) == len && strncmp(group_configs[g].name, name, len) == 0) {
+            return g;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Index of a resource name, registering new names
+ * Names are shared by all contexts so concurrent batch parses agree on
+ * indices. Returns -1 if the name is empty, too long or the table is full.
+ */
+int resource_intern(const char *name, size_t len) {
+    if (len == 0 || len >= RESOURCE_NAME_LEN) {
+        return -1;
+    }
+    pthread_mutex_lock(&resource_mutex);
+    int r;
+    for (r = 0; r < resource_count; r++) {
+        if (strlen(resource_names[r]) == len && strncmp(resource_names[r], name, len) == 0) {
+            break;
+        }
+    }
+    if (r == resource_count) {
+        if (resource_count == MAX_RESOURCES) {
+            r = -1;
+        } else {
+            memcpy(resource_names[r], name, len);
+            resource_names[r][len] = '\0';
+            resource_count++;
+        }
+    }
+    pthread_mutex_unlock(&resource_mutex);
+    if (r < 0) {
+        fprintf(stderr, "Error: More than %d resources\n", MAX_RESOURCES);
+    }
+    return r;
+}
+
+/**
+ * Parse the optional key=value attributes after the six fields
+ * group=NAME puts the process in a --cgroup group, which must have been
+ * declared. res=NAME[:N] makes every N consecutive bursts
+ * (default 2) a critical section holding resource NAME. threads=K makes
+ * a gang job whose bursts run on K cores at once (K <= --cores).
+ * workers=N gives the process N independently scheduled threads.
+ * aio=D makes its I/Os asynchronous with up to D outstanding; with wait=K
+ * it also waits for all of them after every K bursts. mem=MB sets its
+ * working set.
+ * Returns -1 on an unknown key or bad value.
+ */
+static int parse_process_attributes(const char *text, Process *p) {
+    const char *c = text;
+    for (;;) {
+        c += strspn(c, " \t\r\n");
+        if (*c == '\0') {
+            // Gang jobs do not take part in the resource model or own workers
+            if (p->threads > 1 && (p->resource >= 0 || p->workers > 1)) {
+                return -1;
+            }
+            return p->aio_wait_every > 0 && p->aio_depth == 0 ? -1 : 0;
+        }
+        size_t len = strcspn(c, " \t\r\n");
+        const char *eq = memchr(c, '=', len);
+        if (eq == NULL) {
+            return -1;
+        }
+        size_t key_len = eq - c;
+        const char *value = eq + 1;
+        size_t value_len = len - key_len - 1;
+        
+        if (key_len == 5 && strncmp(c, "group", 5) == 0) {
+            p->group = group_lookup(value, value_len);
+            if (p->group < 0) {
+                return -1;
+            }
+        } else if (key_len == 3 && strncmp(c, "res", 3) == 0) {
+            const char *colon = memchr(value, ':', value_len);
+            size_t name_len = colon != NULL ? (size_t)(colon - value) : value_len;
+            p->hold_bursts = 2;
+            if (colon != NULL) {
+                char *end;
+                long n = strtol(colon + 1, &end, 10);
+                if (end != value + value_len || n < 1 || n > INT_MAX) {
+                    return -1;
+                }
+                p->hold_bursts = (int)n;
+            }
+            p->resource = resource_intern(value, name_len);
+            if (p->resource < 0) {
+                return -1;
+            }
+        } else if (key_len == 7 && strncmp(c, "threads", 7) == 0) {
+            char *end;
+            long n = strtol(value, &end, 10);
+            if (end != value + value_len || n < 1 || n > core_count) {
+                return -1;
+            }
+            p->threads = (int)n;
+        } else if (key_len == 7 && strncmp(c, "workers", 7) == 0) {
+            char *end;
+            long n = strtol(value, &end, 10);
+            if (end != value + value_len || n < 1 || n > 1024) {
+                return -1;
+            }
+            p->workers = (int)n;
+        } else if (key_len == 3 && strncmp(c, "aio", 3) == 0) {
+            char *end;
+            long n = strtol(value, &end, 10);
+            if (end != value + value_len || n < 1 || n > AIO_RING_SIZE) {
+                return -1;
+            }
+            p->aio_depth = (int)n;
+        } else if (key_len == 4 && strncmp(c, "wait", 4) == 0) {
+            char *end;
+            long n = strtol(value, &end, 10);
+            if (end != value + value_len || n < 1 || n > INT_MAX) {
+                return -1;
+            }
+            p->aio_wait_every = (int)n;
+        } else if (key_len == 3 && strncmp(c, "mem", 3) == 0) {
+            char *end;
+            long n = strtol(value, &end, 10);
+            if (end != value + value_len || n < 0 || n > INT_MAX) {
+                return -1;
+            }
+            p->mem = (int)n;
+        } else {
+            return -1;
+        }
+        c += len;
+    }
+}
+
+/**
+ * Parse one input line into a freshly initialized PCB
+ * Returns -1 if the line does not hold six integer fields followed by
+ * valid key=value attributes
+ */
+int parse_process_line(const char *line, Process *p) {
+    int pid, arrival, cpu_time, interval, io, priority, consumed;
+    if (sscanf(line, "%d %d %d %d %d %d%n",
+               &pid, &arrival, &cpu_time, &interval, &io, &priority, &consumed) != 6) {
+        return -1;
+    }
+    
+    // Initialize process
+    init_process(p, pid, arrival, cpu_time, interval, io, priority);
+    return parse_process_attributes(line + consumed, p);
+}
+
+/**
+ * Stream the input file one process at a time without loading it
+ * Calls fn for every record in file order; stops early if fn returns nonzero.
+ */
+int for_each_input_record(const char *filename, int (*fn)(const Process *p, void *arg),
+                          void *arg) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        perror("Error opening input file");
+        return -1;
+    }
+    
+    char line[256];
+    int idx = 0;
+    int rc = 0;
+    while (rc == 0 && fgets(line, sizeof(line), file) != NULL) {
+        if (strlen(line) <= 1) continue;  // Skip empty lines
+        
+        Process p;
+        if (parse_process_line(line, &p) != 0) {
+            fprintf(stderr, "Error: Invalid format in input file at line %d\n", idx + 1);
+            rc = -1;
+            break;
+        }
+        rc = fn(&p, arg);
+        idx++;
+    }
+    
+    fclose(file);
+    return rc;
+}
+
+/**
+ * Parse input file and load all processes
+ * File format: [pid] [arrival_time] [cpu_execution_time] [interval_time] [io_time] [priority]
+ */
+int parse_input_file(SimContext *ctx, const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        perror("Error opening input file");
+        return -1;
+    }
+    
+    // Count number of processes
+    ctx->total_processes = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strlen(line) > 1) {  // Skip empty lines
+            ctx->total_processes++;
+        }
+    }
+    
+    if (ctx->total_processes == 0) {
+        fprintf(stderr, "Error: No processes found in input file\n");
+        fclose(file);
+        return -1;
+    }
+    
+    // Allocate memory for processes
+    ctx->processes = (Process *)malloc(sizeof(Process) * ctx->total_processes);
+    if (ctx->processes == NULL) {
+        perror("Error allocating memory for processes");
+        fclose(file);
+        return -1;
+    }
+    
+    // Read processes
+    rewind(file);
+    int idx = 0;
+    while (fgets(line, sizeof(line), file) != NULL && idx < ctx->total_processes) {
+        if (strlen(line) <= 1) continue;  // Skip empty lines
+        
+        if (parse_process_line(line, &ctx->processes[idx]) != 0) {
+            fprintf(stderr, "Error: Invalid format in input file at line %d\n", idx + 1);
+            free(ctx->processes);
+            ctx->processes = NULL;
+            fclose(file);
+            return -1;
+        }
+        
+        idx++;
+    }
+    
+    fclose(file);
+    return sort_by_arrival(ctx);
+}
+
+typedef struct {
+    int *sizes;
+    int count;
+    int capacity;
+} SizeSample;
+
+static int collect_size(const Process *p, void *arg) {
+    SizeSample *sample = (SizeSample *)arg;
+    if (sample->count == sample->capacity) {
+        int new_capacity = sample->capacity ? sample->capacity * 2 : 1024;
+        int *grown = realloc(sample->sizes, sizeof(int) * new_capacity);
+        if (grown == NULL) {
+            perror("Error allocating size sample");
+            return -1;
+        }
+        sample->sizes = grown;
+        sample->capacity = new_capacity;
+    }
+    sample->sizes[sample->count++] = p->cpu_execution_time;
+    return 0;
+}
+
+/**
+ * Learn a Gittins table from the job sizes of a prior workload or trace
+ */
+GittinsTable* load_size_prior(const char *filename) {
+    SizeSample sample = { NULL, 0, 0 };
+    GittinsTable *table = malloc(sizeof(GittinsTable));
+    if (table == NULL || for_each_input_record(filename, collect_size, &sample) != 0 ||
+        gittins_build(table, sample.sizes, sample.count) != 0) {
+        free(table);
+        table = NULL;
+    }
+    free(sample.sizes);
+    return table;
+}
+
+/* ============================================================================
+ * WORKLOAD GENERATION
+ * ============================================================================ */
+
+/**
+ * Synthetic workload parameters (--generate)
+ * Inter-arrival, CPU, burst and I/O times are exponentially distributed
+ */
+typedef struct {
+    int count;                      // Number of processes
+    double mean_interarrival;       // Mean gap between arrivals (ms)
+    double mean_cpu;                // Mean total CPU time (ms)
+    double mean_interval;           // Mean CPU burst length (ms)
+    double mean_io;                 // Mean I/O time (ms)
+    int min_priority;               // Priorities drawn uniformly from
+    int max_priority;               // [min_priority, max_priority]
+} WorkloadSpec;
+
+/**
+ * Parse a generator spec such as "n=1000,iat=20,cpu=50,burst=10,io=5,prio=0-10"
+ */
+int parse_workload_spec(const char *text, WorkloadSpec *spec) {
+    *spec = (WorkloadSpec){ 1000, 20.0, 50.0, 10.0, 5.0, 0, 10 };
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", text);
+    
+    for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        char *eq = strchr(tok, '=');
+        if (eq == NULL) {
+            return -1;
+        }
+        *eq = '\0';
+        const char *val = eq + 1;
+        
+        if (strcmp(tok, "n") == 0) {
+            spec->count = atoi(val);
+        } else if (strcmp(tok, "iat") == 0) {
+            spec->mean_interarrival = atof(val);
+        } else if (strcmp(tok, "cpu") == 0) {
+            spec->mean_cpu = atof(val);
+        } else if (strcmp(tok, "burst") == 0) {
+            spec->mean_interval = atof(val);
+        } else if (strcmp(tok, "io") == 0) {
+            spec->mean_io = atof(val);
+        } else if (strcmp(tok, "prio") == 0) {
+            if (sscanf(val, "%d-%d", &spec->min_priority, &spec->max_priority) != 2) {
+                spec->min_priority = spec->max_priority = atoi(val);
+            }
+        } else {
+            return -1;
+        }
+    }
+    
+    if (spec->count <= 0 || spec->mean_interarrival < 0 || spec->mean_cpu < 1 ||
+        spec->mean_interval < 1 || spec->mean_io < 0 ||
+        spec->min_priority < 0 || spec->max_priority < spec->min_priority) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Fill a context with a synthetic workload drawn from the given stream
+ */
+int generate_workload(SimContext *ctx, const WorkloadSpec *spec, Rng *rng) {
+    ctx->processes = malloc(sizeof(Process) * spec->count);
+    if (ctx->processes == NULL) {
+        perror("Error allocating memory for processes");
+        return -1;
+    }
+    ctx->total_processes = spec->count;
+    
+    double arrival = 0.0;
+    int span = spec->max_priority - spec->min_priority + 1;
+    for (int i = 0; i < spec->count; i++) {
+        arrival += rng_exponential(rng, spec->mean_interarrival);
+        int cpu_time = 1 + (int)rng_exponential(rng, spec->mean_cpu - 1);
+        int interval = 1 + (int)rng_exponential(rng, spec->mean_interval - 1);
+        int io = (int)(rng_exponential(rng, spec->mean_io) + 0.5);
+        int priority = spec->min_priority + (int)(rng_uniform(rng) * span);
+        init_process(&ctx->processes[i], i + 1, (int)arrival, cpu_time,
+                     interval, io, priority);
+    }
+    
+    return 0;  // Arrivals are generated in order, no sort needed
+}
+
+/* ============================================================================
+ * OUTPUT FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Thread-safe print function
+ * Ensures atomic output to prevent interleaved messages
+ */
+void safe_print(const char *format, ...) {
+    pthread_mutex_lock(&output_mutex);
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    fflush(stdout);
+    pthread_mutex_unlock(&output_mutex);
+}
+
+/**
+ * Per-event log line of a simulation run
+ * Suppressed in quiet runs; only real-time runs flush every line
+ */
+void sim_log(SimContext *ctx, const char *format, ...) {
+    if (ctx->quiet) {
+        return;
+    }
+    pthread_mutex_lock(&output_mutex);
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    if (ctx->realtime) {
+        fflush(stdout);
+    }
+    pthread_mutex_unlock(&output_mutex);
+}
+
+/* ============================================================================
+ * GANG SCHEDULING
+ * ============================================================================ */
+
+/**
+ * Add a ready gang job to the index of its size class
+ */
+void gang_enqueue(SimContext *ctx, Process *p) {
+    insert_ready_queue(&ctx->gang_ready[p->threads], p);
+    ctx->gang_classes |= 1ull << (p->threads - 1);
+    ctx->gang_waiting++;
+}
+
+/**
+ * Mask of the size classes of gangs with at most n threads
+ */
+static inline uint64_t gang_classes_upto(int n) {
+    return n >= 64 ? ~0ull : (1ull << n) - 1;
+}
+
+/**
+ * Remove the head of a size class
+ */
+static Process* gang_dequeue(SimContext *ctx, int threads) {
+    Process *p = dequeue(&ctx->gang_ready[threads]);
+    if (is_empty(&ctx->gang_ready[threads])) {
+        ctx->gang_classes &= ~(1ull << (threads - 1));
+    }
+    ctx->gang_waiting--;
+    return p;
+}
+
+/**
+ * Priority-SRTF order between the heads of two size classes
+ */
+static int gang_before(const Process *a, const Process *b) {
+    if (a->priority != b->priority) {
+        return a->priority < b->priority;
+    }
+    if (a->remaining_time != b->remaining_time) {
+        return a->remaining_time < b->remaining_time;
+    }
+    return a->ready_since < b->ready_since;
+}
+
+/**
+ * First gang job among the class heads selected by mask
+ */
+static Process* gang_head(SimContext *ctx, uint64_t mask) {
+    Process *best = NULL;
+    while (mask != 0) {
+        int k = __builtin_ctzll(mask) + 1;
+        mask &= mask - 1;
+        Process *head = ctx->gang_ready[k].head;
+        if (best == NULL || gang_before(head, best)) {
+            best = head;
+        }
+    }
+    return best;
+}
+
+static int burst_length(const Process *p) {
+    return p->interval_time < p->remaining_time ? p->interval_time : p->remaining_time;
+}
+
+/**
+ * Backfill check: may a burst on k cores start now without delaying the
+ * reserved gang job? It must end by the shadow time or fit in the cores
+ * left over once the reservation starts.
+ */
+static int gang_fits(const SimContext *ctx, int burst, int k, int clock) {
+    return ctx->gang_backfill &&
+           (clock + burst <= ctx->shadow_clock || k <= ctx->shadow_extra);
+}
+
+/**
+ * Start a backfilled burst: one running past the shadow time keeps its
+ * k cores, leaving fewer extra cores for the next candidate
+ */
+static void gang_backfill_claim(SimContext *ctx, int burst, int k, int clock) {
+    if (clock + burst > ctx->shadow_clock) {
+        ctx->shadow_extra -= k;
+    }
+}
+
+/**
+ * Print per-class gang waits, backfilling and fragmentation
+ */
+void print_gang_report(SimContext *ctx) {
+    printf("\n=== Gang Report (%s) ===\n", ctx->gang_backfill ? "EASY backfill" : "strict");
+    printf("%-8s %8s %12s %16s\n", "Threads", "Jobs", "Dispatches", "Mean wait (ms)");
+    for (int k = 2; k <= ctx->num_cores; k++) {
+        if (ctx->gang_jobs[k] == 0) {
+            continue;
+        }
+        printf("%-8d %8d %12ld %16.1f\n", k, ctx->gang_jobs[k], ctx->gang_dispatches[k],
+               ctx->gang_dispatches[k] > 0
+               ? (double)ctx->gang_wait[k] / ctx->gang_dispatches[k] : 0.0);
+    }
+    double capacity = (double)ctx->stop_clock * ctx->num_cores;
+    printf("Backfilled bursts: %ld gang, %ld single-thread\n",
+           ctx->backfilled_gang, ctx->backfilled_single);
+    printf("Utilization: %.4f\n", capacity > 0 ? ctx->busy_time / capacity : 0.0);
+    printf("Fragmentation: %ld idle core-ms while gang jobs waited (%.2f%% of capacity lost)\n",
+           ctx->fragmented_time, capacity > 0 ? 100.0 * ctx->fragmented_time / capacity : 0.0);
+}
+
+/* ============================================================================
+ * IDLE STATES
+ * ============================================================================ */
+
+/**
+ * Parse a --cstates list "C1:0/1,C3:20/10,C6:200/50" (ms); residencies
+ * must increase from one state to the next
+ */
+int parse_cstates(const char *list) {
+    const char *c = list;
+    cstate_count = 0;
+    while (*c) {
+        size_t len = strcspn(c, ",");
+        const char *colon = memchr(c, ':', len);
+        int residency, exit_latency, used = 0;
+        if (colon == NULL || colon == c || colon - c >= CSTATE_NAME_LEN ||
+            cstate_count == MAX_CSTATES ||
+            sscanf(colon + 1, "%d/%d%n", &residency, &exit_latency, &used) != 2 ||
+            colon + 1 + used != c + len || residency < 0 || exit_latency < 0 ||
+            exit_latency > MAX_EXIT_LATENCY ||
+            (cstate_count > 0 && residency <= cstates[cstate_count - 1].residency)) {
+            return -1;
+        }
+        CState *state = &cstates[cstate_count++];
+        memcpy(state->name, c, colon - c);
+        state->name[colon - c] = '\0';
+        state->residency = residency;
+        state->exit_latency = exit_latency;
+        c += len;
+        if (*c == ',') {
+            c++;
+        }
+    }
+    return cstate_count > 0 ? 0 : -1;
+}
+
+/**
+ * Deepest state reached after idle ms, -1 if none
+ */
+static int cstate_reached(int idle) {
+    int s = -1;
+    while (s + 1 < cstate_count && idle >= cstates[s + 1].residency) {
+        s++;
+    }
+    return s;
+}
+
+/**
+ * Split an idle period over the states the core passed through
+ */
+static void cstate_account(SimContext *ctx, int idle) {
+    ctx->shallow_idle += idle < cstates[0].residency ? idle : cstates[0].residency;
+    for (int s = 0; s < cstate_count && idle > cstates[s].residency; s++) {
+        int until = s + 1 < cstate_count && cstates[s + 1].residency < idle
+                    ? cstates[s + 1].residency : idle;
+        ctx->cstate_residency[s] += until - cstates[s].residency;
+    }
+}
+
+/**
+ * Wake a core for a dispatch at clock; returns the exit latency of the
+ * idle state it reached
+ */
+int core_wake(SimContext *ctx, Core *core, int clock) {
+    int idle = clock - core->running_until;
+    if (cstate_count == 0 || idle <= 0) {
+        return 0;
+    }
+    cstate_account(ctx, idle);
+    int s = cstate_reached(idle);
+    int latency = s >= 0 ? cstates[s].exit_latency : 0;
+    ctx->wakeups++;
+    ctx->wake_hist[latency]++;
+    if (s >= 0) {
+        ctx->cstate_wakeups[s]++;
+        if (latency > 0) {
+            sim_log(ctx, "[Clock: %d] Core %d waking from %s after %d ms idle (%d ms)\n",
+                    clock, (int)(core - ctx->cores), cstates[s].name, idle, latency);
+        }
+    }
+    return latency;
+}
+
+/**
+ * Latency below which a fraction q of the wakeups fall
+ */
+static int wake_quantile(const SimContext *ctx, double q) {
+    long target = (long)(q * (ctx->wakeups - 1));
+    long seen = 0;
+    for (int l = 0; l <= MAX_EXIT_LATENCY; l++) {
+        seen += ctx->wake_hist[l];
+        if (seen > target) {
+            return l;
+        }
+    }
+    return MAX_EXIT_LATENCY;
+}
+
+/**
+ * Print idle residency per state and the wakeup latency distribution
+ */
+void print_cstate_report(SimContext *ctx) {
+    // Cores idle at the end of the run are still in their idle period
+    for (int c = 0; c < ctx->num_cores; c++) {
+        const Core *core = &ctx->cores[c];
+        if (core->running_process == NULL && ctx->stop_clock > core->running_until) {
+            cstate_account(ctx, ctx->stop_clock - core->running_until);
+        }
+    }
+    
+    double capacity = (double)ctx->stop_clock * ctx->num_cores;
+    printf("\n=== Idle State Report ===\n");
+    printf("%-8s %10s %12s %10s %10s\n", "State", "Exit (ms)", "Residency", "Share", "Wakeups");
+    printf("%-8s %10s %12ld %9.2f%% %10s\n", "shallow", "-", ctx->shallow_idle,
+           capacity > 0 ? 100.0 * ctx->shallow_idle / capacity : 0.0, "-");
+    for (int s = 0; s < cstate_count; s++) {
+        printf("%-8s %10d %12ld %9.2f%% %10ld\n", cstates[s].name, cstates[s].exit_latency,
+               ctx->cstate_residency[s],
+               capacity > 0 ? 100.0 * ctx->cstate_residency[s] / capacity : 0.0,
+               ctx->cstate_wakeups[s]);
+    }
+    
+    double total = 0.0;
+    for (int l = 0; l <= MAX_EXIT_LATENCY; l++) {
+        total += (double)l * ctx->wake_hist[l];
+    }
+    printf("Dispatches onto idle cores: %ld\n", ctx->wakeups);
+    if (ctx->wakeups > 0) {
+        printf("Wakeup latency (ms): mean %.2f, p50 %d, p95 %d, p99 %d, max %d\n",
+               total / ctx->wakeups, wake_quantile(ctx, 0.50), wake_quantile(ctx, 0.95),
+               wake_quantile(ctx, 0.99), wake_quantile(ctx, 1.0));
+    }
+}
+
+/* ============================================================================
+ * CPU BANDWIDTH GROUPS
+ * ============================================================================ */
+
+/**
+ * Parse a --cgroup spec "NAME:QUOTA/PERIOD" (ms) into the group table
+ */
+int parse_group_spec(const char *spec) {
+    const char *colon = strchr(spec, ':');
+    int quota, period;
+    char extra;
+    if (colon == NULL || colon == spec || colon - spec >= GROUP_NAME_LEN ||
+        group_count == MAX_GROUPS ||
+        sscanf(colon + 1, "%d/%d%c", &quota, &period, &extra) != 2 ||
+        quota < 1 || period < 1 || group_lookup(spec, colon - spec) >= 0) {
+        return -1;
+    }
+    GroupConfig *cfg = &group_configs[group_count++];
+    memcpy(cfg->name, spec, colon - spec);
+    cfg->name[colon - spec] = '\0';
+    cfg->quota = quota;
+    cfg->period = period;
+    return 0;
+}
+
+/**
+ * Roll a group's usage forward to the period containing clock
+ * Each elapsed period pays back up to one quota of earlier overrun.
+ */
+static void group_refill(SimContext *ctx, int g, int clock) {
+    const GroupConfig *cfg = &group_configs[g];
+    GroupState *state = &ctx->groups[g];
+    int period = clock / cfg->period;
+    if (period > state->period_index) {
+        state->used -= (long)cfg->quota * (period - state->period_index);
+        if (state->used < 0) {
+            state->used = 0;
+        }
+        state->period_index = period;
+    }
+}
+
+/**
+ * Charge a completed burst to the process's group, throttling the group
+ * once the quota of the current period is used up
+ */
+void group_charge(SimContext *ctx, const Process *p, int burst_time, int clock) {
+    if (p->group < 0) {
+        return;
+    }
+    const GroupConfig *cfg = &group_configs[p->group];
+    GroupState *state = &ctx->groups[p->group];
+    group_refill(ctx, p->group, clock);
+    state->used += burst_time;
+    state->runtime += burst_time;
+    
+    if (!state->throttled && state->used >= cfg->quota) {
+        state->throttled = 1;
+        state->throttled_since = clock;
+        state->throttle_count++;
+        timer_push(&ctx->timers, (state->period_index + 1) * cfg->period,
+                   TIMER_GROUP_REFRESH, p->group);
+        sim_log(ctx, "[Clock: %d] Group %s throttled (%ld of %d ms used)\n",
+                clock, cfg->name, state->used, cfg->quota);
+    }
+}
+
+/**
+ * Make a process ready: onto a core, or aside if its group is throttled
+ */
+void make_ready(SimContext *ctx, Process *p) {
+    if (p->group >= 0 && ctx->groups[p->group].throttled) {
+        enqueue(&ctx->groups[p->group].held, p);
+        return;
+    }
+    if (p->threads > 1) {
+        gang_enqueue(ctx, p);
+        return;
+    }
+    core_enqueue(ctx, choose_core(ctx, p), p);
+}
+
+/**
+ * Period refresh of a throttled group: release its held processes once
+ * the overrun has been paid back, otherwise wait for the next period
+ */
+void group_refresh(SimContext *ctx, int g, int clock) {
+    const GroupConfig *cfg = &group_configs[g];
+    GroupState *state = &ctx->groups[g];
+    group_refill(ctx, g, clock);
+    if (state->used >= cfg->quota) {
+        timer_push(&ctx->timers, (state->period_index + 1) * cfg->period,
+                   TIMER_GROUP_REFRESH, g);
+        return;
+    }
+    
+    int duration = clock - state->throttled_since;
+    state->throttled = 0;
+    state->throttled_time += duration;
+    if (duration > state->max_throttle) {
+        state->max_throttle = duration;
+    }
+    sim_log(ctx, "[Clock: %d] Group %s unthrottled after %d ms\n", clock, cfg->name, duration);
+    
+    while (!is_empty(&state->held)) {
+        make_ready(ctx, dequeue(&state->held));
+    }
+}
+
+/**
+ * Print throttle counts and durations of every group
+ */
+void print_group_report(SimContext *ctx) {
+    printf("\n=== Bandwidth Group Report ===\n");
+    printf("%-16s %8s %8s %12s %10s %14s %12s %12s\n", "Group", "Quota", "Period",
+           "Runtime (ms)", "Throttles", "Throttled (ms)", "Mean (ms)", "Max (ms)");
+    for (int g = 0; g < ctx->num_groups; g++) {
+        const GroupConfig *cfg = &group_configs[g];
+        const GroupState *state = &ctx->groups[g];
+        
+        // A throttle still open at the end of the run counts up to the stop clock
+        long total = state->throttled_time;
+        int max = state->max_throttle;
+        if (state->throttled) {
+            int open = ctx->stop_clock - state->throttled_since;
+            total += open;
+            max = open > max ? open : max;
+        }
+        printf("%-16s %8d %8d %12ld %10ld %14ld %12.1f %12d\n", cfg->name, cfg->quota,
+               cfg->period, state->runtime, state->throttle_count, total,
+               state->throttle_count > 0 ? (double)total / state->throttle_count : 0.0, max);
+    }
+}
+
+/* ============================================================================
+ * SHARED RESOURCES
+ * ============================================================================ */
+
+/**
+ * Size every waiter heap for its users and compute priority ceilings
+ * If a waiter heap cannot be allocated the run ignores its resources.
+ */
+void resources_setup(SimContext *ctx) {
+    ctx->lock_protocol = lock_protocol;
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        ctx->resources[r].ceiling = MAX_PRIORITY;
+    }
+    for (int i = 0; i < ctx->total_processes; i++) {
+        const Process *p = &ctx->processes[i];
+        if (p->resource >= 0) {
+            ResourceState *res = &ctx->resources[p->resource];
+            res->users += p->workers;   // Every thread may wait on it
+            if (p->original_priority < res->ceiling) {
+                res->ceiling = p->original_priority;
+            }
+        }
+    }
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        ResourceState *res = &ctx->resources[r];
+        if (res->users > 0 && res->waiters == NULL) {
+            res->waiters = malloc(sizeof(Process *) * res->users);
+            if (res->waiters == NULL) {
+                perror("Error allocating resource waiters");
+                for (int i = 0; i < ctx->total_processes; i++) {
+                    ctx->processes[i].resource = -1;
+                }
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * Raise a process to a better (numerically lower) priority, repositioning
+ * it if it sits in a ready queue: O(log n) in a ready heap
+ */
+static void boost_priority(SimContext *ctx, Process *p, int priority) {
+    Process *pcb = pcb_of(p);
+    if (priority >= pcb->priority) {
+        return;
+    }
+    if (pcb->boosted_from < 0) {
+        pcb->boosted_from = pcb->priority;
+    }
+    pcb->priority = priority;
+    
+    if (pcb->workers > 1) {
+        resort_all_queues(ctx);
+    } else if (p->state == STATE_READY && p->core >= 0) {
+        Core *core = &ctx->cores[p->core];
+        if (ctx->policy != POLICY_SRTF) {
+            heap_sift_up(core->heap, p->heap_pos);
+        } else {
+            remove_from_queue(&core->ready_queue, p);
+            insert_ready_queue(&core->ready_queue, p);
+        }
+    }
+}
+
+/**
+ * Give a free resource to p; the ceiling protocol boosts it immediately
+ */
+static void resource_grant(SimContext *ctx, Process *p) {
+    ResourceState *res = &ctx->resources[p->resource];
+    res->holder = p;
+    res->acquisitions++;
+    p->held_bursts_left = p->hold_bursts;
+    if (ctx->lock_protocol == LOCKS_CEILING) {
+        boost_priority(ctx, p, res->ceiling);
+    }
+}
+
+/**
+ * Acquire p's resource before its critical section
+ * Returns 1 if p holds it, 0 if p blocked; a blocked process passes its
+ * priority to the holder under the inheritance protocol.
+ */
+int resource_acquire(SimContext *ctx, Process *p, int clock) {
+    ResourceState *res = &ctx->resources[p->resource];
+    if (res->holder == NULL) {
+        resource_grant(ctx, p);
+        return 1;
+    }
+    
+    Process *holder = res->holder;
+    p->state = STATE_BLOCKED;
+    p->blocked_since = clock;
+    p->blocked_by_lower = holder->original_priority > p->original_priority;
+    heap_push(res->waiters, &res->waiter_count, p);
+    res->contended++;
+    
+    if (ctx->lock_protocol == LOCKS_INHERIT) {
+        boost_priority(ctx, holder, sched_priority(res->waiters[0]));
+    }
+    sim_log(ctx, "[Clock: %d] PID %d blocked on resource %s held by PID %d\n",
+            clock, p->pid, resource_names[p->resource], holder->pid);
+    return 0;
+}
+
+/**
+ * Release p's resource and hand it to the highest-priority waiter
+ */
+void resource_release(SimContext *ctx, Process *p, int clock) {
+    ResourceState *res = &ctx->resources[p->resource];
+    p->held_bursts_left = 0;
+    Process *pcb = pcb_of(p);
+    if (pcb->boosted_from >= 0) {
+        pcb->priority = pcb->boosted_from;  // Includes any aging while boosted
+        pcb->boosted_from = -1;
+        if (pcb->workers > 1) {
+            resort_all_queues(ctx);
+        }
+    }
+    res->holder = NULL;
+    if (res->waiter_count == 0) {
+        return;
+    }
+    
+    Process *next = heap_pop(res->waiters, &res->waiter_count);
+    int blocked = clock - next->blocked_since;
+    int cls = priority_class(next->original_priority);
+    ctx->lock_blocks[cls]++;
+    ctx->lock_blocked_time[cls] += blocked;
+    if (next->blocked_by_lower) {
+        ctx->inversion_time[cls] += blocked;
+    }
+    if (blocked > ctx->max_blocked[cls]) {
+        ctx->max_blocked[cls] = blocked;
+    }
+    
+    resource_grant(ctx, next);
+    if (ctx->lock_protocol == LOCKS_INHERIT && res->waiter_count > 0) {
+        boost_priority(ctx, next, sched_priority(res->waiters[0]));
+    }
+    sim_log(ctx, "[Clock: %d] PID %d acquired resource %s after %d ms\n",
+            clock, next->pid, resource_names[next->resource], blocked);
+    next->state = STATE_READY;
+    make_ready(ctx, next);
+}
+
+/**
+ * Account a completed burst of a resource user: release after the last
+ * burst of its critical section, or when the process finishes
+ */
+void resource_burst_done(SimContext *ctx, Process *p, int clock) {
+    if (p->held_bursts_left > 0 && (--p->held_bursts_left == 0 || p->remaining_time <= 0)) {
+        resource_release(ctx, p, clock);
+    }
+}
+
+/**
+ * Print resource waits and the part caused by priority inversion
+ */
+void print_resource_report(SimContext *ctx) {
+    printf("\n=== Resource Report (%s) ===\n", lock_protocol_names[ctx->lock_protocol]);
+    printf("%-16s %8s %12s %12s\n", "Resource", "Ceiling", "Acquisitions", "Contended");
+    for (int r = 0; r < resource_count; r++) {
+        const ResourceState *res = &ctx->resources[r];
+        if (res->users > 0) {
+            printf("%-16s %8d %12ld %12ld\n", resource_names[r], res->ceiling,
+                   res->acquisitions, res->contended);
+        }
+    }
+    printf("%-3s %10s %14s %16s %14s %12s\n", "Pr", "Blocks", "Blocked (ms)",
+           "Inversion (ms)", "Mean (ms)", "Max (ms)");
+    for (int k = 0; k < NUM_PRIORITIES; k++) {
+        if (ctx->lock_blocks[k] == 0) {
+            continue;
+        }
+        printf("%-3d %10ld %14ld %16ld %14.1f %12d\n", k, ctx->lock_blocks[k],
+               ctx->lock_blocked_time[k], ctx->inversion_time[k],
+               (double)ctx->lock_blocked_time[k] / ctx->lock_blocks[k], ctx->max_blocked[k]);
+    }
+}
+
+/* ============================================================================
+ * WORKER THREADS
+ * ============================================================================ */
+
+/**
+ * Allocate the worker thread pool: one slot for every extra thread of the
+ * workload, so spawning never calls malloc. Returns -1 on failure.
+ */
+int threads_setup(SimContext *ctx) {
+    int slots = 0;
+    for (int i = 0; i < ctx->total_processes; i++) {
+        slots += ctx->processes[i].workers - 1;
+    }
+    if (slots == 0) {
+        return 0;
+    }
+    ctx->thread_pool = malloc(sizeof(Process) * slots);
+    if (ctx->thread_pool == NULL) {
+        perror("Error allocating thread pool");
+        return -1;
+    }
+    ctx->pool_size = slots;
+    ctx->free_threads = NULL;
+    for (int t = slots - 1; t >= 0; t--) {
+        ctx->thread_pool[t].next = ctx->free_threads;
+        ctx->free_threads = &ctx->thread_pool[t];
+    }
+    return 0;
+}
+
+/**
+ * Start worker thread tid of an arriving process
+ * The thread copies the process's burst/IO pattern and group; its priority
+ * is read from and aged in the process.
+ */
+static void spawn_thread(SimContext *ctx, Process *p, int tid, int clock) {
+    Process *t = ctx->free_threads;
+    ctx->free_threads = t->next;
+    
+    *t = *p;
+    t->tid = tid;
+    t->owner = p;
+    t->workers = 1;
+    t->core = -1;
+    t->heap_pos = -1;
+    t->next = NULL;
+    memset(t->task.slots, 0, sizeof(t->task.slots));
+    
+    ctx->threads_spawned++;
+    if (++ctx->live_workers > ctx->peak_workers) {
+        ctx->peak_workers = ctx->live_workers;
+    }
+    sim_log(ctx, "[Clock: %d] PID %d spawned thread %d\n", clock, p->pid, tid);
+    make_ready(ctx, t);
+}
+
+/**
+ * Start the worker threads of an arriving process
+ */
+void spawn_threads(SimContext *ctx, Process *p, int clock) {
+    p->live_threads = p->workers;
+    for (int tid = 1; tid < p->workers; tid++) {
+        spawn_thread(ctx, p, tid, clock);
+    }
+}
+
+/**
+ * One thread of a process used up its CPU time
+ * Returns the process once its last thread has exited, else NULL.
+ */
+Process* thread_exit(SimContext *ctx, Process *t, int clock) {
+    Process *p = pcb_of(t);
+    t->state = STATE_TERMINATED;
+    if (t->owner != NULL) {
+        t->next = ctx->free_threads;
+        ctx->free_threads = t;
+        ctx->live_workers--;
+    }
+    if (--p->live_threads == 0) {
+        return p;
+    }
+    sim_log(ctx, "[Clock: %d] PID %d thread %d exited\n", clock, p->pid, t->tid);
+    return NULL;
+}
+
+/**
+ * Print worker thread pool usage
+ */
+void print_thread_report(SimContext *ctx) {
+    printf("\n=== Thread Report ===\n");
+    printf("Worker threads spawned: %ld\n", ctx->threads_spawned);
+    printf("Peak live workers: %d of %d pool slots (%zu bytes each)\n",
+           ctx->peak_workers, ctx->pool_size, sizeof(Process));
+}
+
+/* ============================================================================
+ * ASYNCHRONOUS I/O
+ * ============================================================================ */
+
+/**
+ * Retire asynchronous I/Os that have completed by clock
+ */
+static void aio_retire(Process *p, int clock) {
+    while (p->aio_count > 0 && p->aio_ring[p->aio_head] <= clock) {
+        p->aio_head = (p->aio_head + 1) % AIO_RING_SIZE;
+        p->aio_count--;
+    }
+}
+
+/**
+ * Issue the I/O that follows a burst without blocking
+ * The process stays runnable unless all aio_depth slots are in use; then
+ * it blocks until the oldest I/O completes and issues the new one in its
+ * slot. Returns 1 if the process blocked.
+ */
+int aio_issue(SimContext *ctx, Process *p, int clock) {
+    aio_retire(p, clock);
+    ctx->aio_issued++;
+    
+    int issue_at = clock;
+    if (p->aio_count == p->aio_depth) {
+        issue_at = p->aio_ring[p->aio_head];
+        p->aio_head = (p->aio_head + 1) % AIO_RING_SIZE;
+        p->aio_count--;
+    }
+    p->aio_ring[(p->aio_head + p->aio_count) % AIO_RING_SIZE] = issue_at + p->io_time;
+    p->aio_count++;
+    
+    if (issue_at == clock) {
+        ctx->aio_overlapped++;
+        sim_log(ctx, "[Clock: %d] PID %d issued async I/O for %d ms (%d outstanding)\n",
+                clock, p->pid, p->io_time, p->aio_count);
+        return 0;
+    }
+    
+    ctx->aio_stalls++;
+    ctx->aio_stall_time += issue_at - clock;
+    p->state = STATE_WAITING;
+    p->io_completion_time = issue_at;
+    hook_fire(SCHED_HOOK_IO_START, p, clock);
+    sim_log(ctx, "[Clock: %d] PID %d blocked on %d outstanding I/Os until %d\n",
+            clock, p->pid, p->aio_depth, issue_at);
+    enqueue(&ctx->waiting_queue, p);
+    return 1;
+}
+
+/**
+ * Explicit wait before exit: returns 1 if the process has I/Os outstanding
+ * and now waits for the last of them
+ */
+int aio_drain(SimContext *ctx, Process *p, int clock) {
+    aio_retire(p, clock);
+    if (p->aio_count == 0) {
+        return 0;
+    }
+    int last = p->aio_ring[(p->aio_head + p->aio_count - 1) % AIO_RING_SIZE];
+    ctx->aio_drains++;
+    ctx->aio_drain_time += last - clock;
+    p->state = STATE_WAITING;
+    p->io_completion_time = last;
+    hook_fire(SCHED_HOOK_IO_START, p, clock);
+    sim_log(ctx, "[Clock: %d] PID %d waiting for %d outstanding I/Os\n",
+            clock, p->pid, p->aio_count);
+    enqueue(&ctx->waiting_queue, p);
+    return 1;
+}
+
+/**
+ * Explicit wait every wait= bursts, after the burst's I/O was issued: block
+ * until every outstanding I/O has completed. stalled says whether issuing
+ * already blocked p on a full ring; the wait then extends that block.
+ * Returns 1 if p is blocked.
+ */
+int aio_wait(SimContext *ctx, Process *p, int clock, int stalled) {
+    if (p->aio_wait_every == 0 || ++p->aio_bursts < p->aio_wait_every) {
+        return stalled;
+    }
+    p->aio_bursts = 0;
+    int last = p->aio_ring[(p->aio_head + p->aio_count - 1) % AIO_RING_SIZE];
+    int from = stalled ? p->io_completion_time : clock;
+    if (last <= from) {
+        return stalled;
+    }
+    ctx->aio_waits++;
+    ctx->aio_wait_time += last - from;
+    p->io_completion_time = last;
+    if (stalled) {
+        return 1;  // Already in the waiting queue
+    }
+    
+    p->state = STATE_WAITING;
+    hook_fire(SCHED_HOOK_IO_START, p, clock);
+    sim_log(ctx, "[Clock: %d] PID %d waiting for %d outstanding I/Os\n",
+            clock, p->pid, p->aio_count);
+    enqueue(&ctx->waiting_queue, p);
+    return 1;
+}
+
+/**
+ * Print how much I/O overlapped with computation
+ */
+void print_aio_report(SimContext *ctx) {
+    printf("\n=== Async I/O Report ===\n");
+    printf("I/Os issued: %ld (%.1f%% without blocking)\n", ctx->aio_issued,
+           ctx->aio_issued > 0 ? 100.0 * ctx->aio_overlapped / ctx->aio_issued : 0.0);
+    printf("Full-ring stalls: %ld, %ld ms blocked\n", ctx->aio_stalls, ctx->aio_stall_time);
+    printf("Waits before exit: %ld, %ld ms blocked\n", ctx->aio_drains, ctx->aio_drain_time);
+    if (ctx->aio_waits > 0) {
+        printf("Explicit waits: %ld, %ld ms blocked\n", ctx->aio_waits, ctx->aio_wait_time);
+    }
+}
+
+/* ============================================================================
+ * PAGE FAULTS
+ * ============================================================================ */
+
+#define STACK_PREFAULT (256 * 1024)     // Stack each thread touches up front
+#define LOG_BUFFER_SIZE (64 * 1024)
+
+char log_buffer[LOG_BUFFER_SIZE];       // stdout buffer, installed by --lock-memory
+
+/**
+ * System page size, looked up once
+ */
+static long page_size(void) {
+    static long page = 0;
+    if (page == 0) {
+        page = sysconf(_SC_PAGESIZE) > 0 ? sysconf(_SC_PAGESIZE) : 4096;
+    }
+    return page;
+}
+
+/**
+ * Write to every page of a range so later accesses cannot fault
+ */
+static long prefault_range(void *mem, size_t bytes) {
+    long page = page_size();
+    volatile char *c = mem;
+    for (size_t i = 0; mem != NULL && i < bytes; i += page) {
+        c[i] = c[i];
+    }
+    if (mem != NULL && bytes > 0) {
+        c[bytes - 1] = c[bytes - 1];
+    }
+    return mem != NULL ? (long)bytes : 0;
+}
+
+/**
+ * Touch STACK_PREFAULT bytes below the calling frame
+ * Every page is stored to through the volatile array: a memset of it would
+ * cast volatile away and may be dropped as a dead store.
+ */
+void prefault_stack(void) {
+    volatile char stack[STACK_PREFAULT];
+    long page = page_size();
+    for (size_t i = 0; i < sizeof(stack); i += page) {
+        stack[i] = 0;
+    }
+    stack[sizeof(stack) - 1] = 0;
+}
+
+/**
+ * Minor and major faults of the whole process so far
+ */
+static void fault_counts(long *minor, long *major) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    *minor = usage.ru_minflt;
+    *major = usage.ru_majflt;
+}
+
+/**
+ * Lock and prefault everything the scheduler touches during the run, then
+ * start counting faults. Called once the run's tables are allocated; locking
+ * or SCHED_FIFO may be refused, which the fault report records.
+ */
+void fault_prepare(SimContext *ctx) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+        ctx->memory_locked = 1;
+    } else {
+        ctx->mlock_error = errno;
+    }
+    
+    ctx->prefaulted += prefault_range(ctx->processes, sizeof(Process) * ctx->total_processes);
+    ctx->prefaulted += prefault_range(ctx->thread_pool, sizeof(Process) * ctx->pool_size);
+    
+    // The timer heap never grows during the run: at most one pending arrival
+    // per closed-system user and one refresh per group join the armed timers
+    timer_reserve(&ctx->timers, ctx->timers.size + ctx->total_processes + ctx->num_groups + 1);
+    ctx->prefaulted += prefault_range(ctx->timers.items, sizeof(Timer) * ctx->timers.capacity);
+    for (int c = 0; c < ctx->num_cores; c++) {
+        if (ctx->cores[c].heap != NULL) {
+            ctx->prefaulted += prefault_range(ctx->cores[c].heap, sizeof(Process *) *
+                                              (ctx->total_processes + ctx->pool_size + 1));
+        }
+    }
+    prefault_range(log_buffer, sizeof(log_buffer));
+    prefault_stack();
+    
+    if (ctx->fifo_priority > 0) {
+        struct sched_param param = { .sched_priority = ctx->fifo_priority };
+        ctx->fifo_error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    }
+    fault_counts(&ctx->minor_faults, &ctx->major_faults);
+}
+
+/**
+ * Faults taken since fault_prepare
+ */
+void fault_finish(SimContext *ctx) {
+    long minor, major;
+    fault_counts(&minor, &major);
+    ctx->minor_faults = minor - ctx->minor_faults;
+    ctx->major_faults = major - ctx->major_faults;
+}
+
+void print_fault_report(SimContext *ctx) {
+    printf("\n=== Page Fault Report ===\n");
+    if (ctx->memory_locked) {
+        printf("Memory: locked (current and future mappings)\n");
+    } else {
+        printf("Memory: not locked, mlockall failed: %s\n", strerror(ctx->mlock_error));
+    }
+    printf("Prefaulted: %ld KB of tables, %d KB of stack per thread, %d KB log buffer\n",
+           ctx->prefaulted / 1024, STACK_PREFAULT / 1024, LOG_BUFFER_SIZE / 1024);
+    if (ctx->fifo_priority == 0) {
+        printf("Scheduler thread: default policy\n");
+    } else if (ctx->fifo_error == 0) {
+        printf("Scheduler thread: SCHED_FIFO priority %d\n", ctx->fifo_priority);
+    } else {
+        printf("Scheduler thread: default policy, SCHED_FIFO refused: %s\n",
+               strerror(ctx->fifo_error));
+    }
+    printf("Faults during the run: %ld major, %ld minor\n", ctx->major_faults, ctx->minor_faults);
+}
+
+/* ============================================================================
+ * I/O MANAGER THREAD
+ * ============================================================================ */
+
+/**
+ * Move every process whose I/O has completed back to the ready queue
+ * Caller must hold queue_mutex
+ */
+void complete_io(SimContext *ctx, int clock) {
+    Queue *waiting_queue = &ctx->waiting_queue;
+    
+    // Check all processes in waiting queue
+    Process *current = waiting_queue->head;
+    Process *prev = NULL;
+    
+    while (current != NULL) {
+        if (clock >= current->io_completion_time) {
+            // I/O completed
+            Process *completed = current;
+            current = current->next;
+            
+            // Remove from waiting queue
+            if (prev == NULL) {
+                waiting_queue->head = completed->next;
+                if (waiting_queue->head == NULL) {
+                    waiting_queue->tail = NULL;
+                }
+            } else {
+                prev->next = completed->next;
+                if (completed->next == NULL) {
+                    waiting_queue->tail = prev;
+                }
+            }
+            waiting_queue->size--;
+            
+            completed->next = NULL;
+            hook_fire(SCHED_HOOK_IO_END, completed, clock);
+            
+            // A finished process was only waiting for its asynchronous I/Os
+            if (completed->remaining_time <= 0) {
+                completed->aio_count = 0;
+                enqueue(&ctx->drained, completed);
+                continue;
+            }
+            
+            completed->state = STATE_READY;
+            completed->ready_since = clock;
+            
+            // Output: I/O finished
+            sim_log(ctx, "[Clock: %d] PID %d finished I/O\n", clock, completed->pid);
+            
+            // Move to the ready queue chosen by the dispatch policy
+            make_ready(ctx, completed);
+            
+            sim_log(ctx, "[Clock: %d] PID %d moved to READY queue\n", clock, completed->pid);
+        
+        } else {
+            prev = current;
+            current = current->next;
+        }
+    }
+}
+
+/**
+ * I/O Manager Thread Function
+ * 
+ * Manages processes in the waiting queue. Checks each millisecond if any
+ * process has completed its I/O operation and moves it back to ready queue.
+ * Only used in real-time runs; virtual-time runs complete I/O inline.
+ */
+void* io_manager_thread(void *arg) {
+    SimContext *ctx = (SimContext *)arg;
+    
+    if (ctx->lock_memory) {
+        prefault_stack();
+    }
+    while (!ctx->all_terminated) {
+        usleep(1000);  // Sleep for 1ms
+        
+        pthread_mutex_lock(&ctx->clock_mutex);
+        int clock = ctx->current_clock;
+        pthread_mutex_unlock(&ctx->clock_mutex);
+        
+        pthread_mutex_lock(&ctx->queue_mutex);
+        complete_io(ctx, clock);
+        pthread_mutex_unlock(&ctx->queue_mutex);
+    }
+    
+    return NULL;
+}
+
+/* ============================================================================
+ * AGING MECHANISM
+ * ============================================================================ */
+
+/**
+ * Age one ready process or worker thread; returns 1 if its priority changed
+ * Threads keep their own wait timers but age their process's priority, so
+ * every 100 ms waited by any of its threads raises it one step.
+ */
+static int age_process(Process *current, int elapsed_ms) {
+    current->time_in_ready_queue += elapsed_ms;
+    
+    // Check if 100ms threshold reached
+    if (current->time_in_ready_queue >= 100) {
+        int aging_steps = current->time_in_ready_queue / 100;
+        current->time_in_ready_queue %= 100;  // Keep remainder
+        Process *pcb = pcb_of(current);
+        
+        // A boosted process also ages the priority it returns to on release
+        if (pcb->boosted_from > 0) {
+            pcb->boosted_from = pcb->boosted_from > aging_steps
+                                ? pcb->boosted_from - aging_steps : 0;
+        }
+        
+        // Decrement priority (but not below 0)
+        if (pcb->priority > 0) {
+            pcb->priority -= aging_steps;
+            if (pcb->priority < 0) {
+                pcb->priority = 0;
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Update aging for all processes in ready queue
+ * Decrement priority by 1 for every 100ms spent in ready queue
+ * Priority cannot go below 0. Returns 1 if a priority changed.
+ */
+int update_aging(Queue *ready_queue, int elapsed_ms, int clock) {
+    Process *current = ready_queue->head;
+    int changed = 0;
+    
+    while (current != NULL) {
+        if (age_process(current, elapsed_ms)) {
+            changed = 1;
+            hook_fire(SCHED_HOOK_AGING, current, clock);
+        }
+        current = current->next;
+    }
+    return changed;
+}
+
+/**
+ * Age a ready heap; the heap is only rebuilt if a priority changed
+ * Returns 1 if one did.
+ */
+int update_aging_heap(Process **heap, int size, int elapsed_ms, int clock) {
+    int changed = 0;
+    for (int i = 0; i < size; i++) {
+        if (age_process(heap[i], elapsed_ms)) {
+            changed = 1;
+            hook_fire(SCHED_HOOK_AGING, heap[i], clock);
+        }
+    }
+    if (changed) {
+        heap_rebuild(heap, size);
+    }
+    return changed;
+}
+
+/* ============================================================================
+ * STEADY-STATE DETECTION
+ * ============================================================================ */
+
+#define MSER_BATCH_SIZE 5           // Observations per MSER-5 batch
+#define CI_BATCHES 20               // Batch means used for confidence intervals
+#define MIN_MSER_BATCHES (4 * CI_BATCHES)
+
+/**
+ * Two-sided 95% Student-t quantile for the given degrees of freedom
+ */
+double t_quantile_975(int df) {
+    static const double table[] = {
+        0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+        2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+        2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045,
+        2.042
+    };
+    if (df <= 0) {
+        return 0.0;
+    }
+    if (df <= 30) {
+        return table[df];
+    }
+    if (df <= 60) {
+        return 2.000 + (2.042 - 2.000) * (60 - df) / 30.0;
+    }
+    if (df <= 120) {
+        return 1.980 + (2.000 - 1.980) * (120 - df) / 60.0;
+    }
+    return 1.960;
+}
+
+/**
+ * Parse a comma-separated metric list (e.g. "wait,turnaround") into a mask
+ * Returns 0 on an unknown metric name
+ */
+unsigned parse_steady_metrics(const char *list) {
+    unsigned mask = 0;
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", list);
+    
+    for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        int found = 0;
+        for (int m = 0; m < NUM_STEADY_METRICS; m++) {
+            if (strcmp(tok, steady_metric_names[m]) == 0) {
+                mask |= 1u << m;
+                found = 1;
+            }
+        }
+        if (!found) {
+            return 0;
+        }
+    }
+    return mask;
+}
+
+/**
+ * MSER truncation point over the completed batch means
+ * Picks d minimizing Var(Z[d..k-1]) / (k-d), searched over d <= k/2.
+ * Returns -1 if the minimum sits on the search boundary, i.e. the
+ * warm-up transient has not yet been observed to end.
+ */
+int mser_truncation(const SteadyMetric *m) {
+    int k = m->batches;
+    double sum = 0.0, sum_sq = 0.0;
+    double best = INFINITY;
+    int best_d = -1;
+    
+    // Walk d from k-1 down to 0 accumulating suffix sums
+    for (int d = k - 1; d >= 0; d--) {
+        double z = m->batch_means[d];
+        sum += z;
+        sum_sq += z * z;
+        
+        int n = k - d;
+        if (d > k / 2 || n < 2) {
+            continue;
+        }
+        double sse = sum_sq - sum * sum / n;
+        double stat = sse / ((double)n * n);
+        if (stat <= best) {
+            best = stat;
+            best_d = d;
+        }
+    }
+    
+    return best_d == k / 2 ? -1 : best_d;
+}
+
+/**
+ * Recompute the steady-state estimate of a metric
+ * Deletes the MSER warm-up, then forms CI_BATCHES batch means from the
+ * remaining MSER-5 batches and derives a 95% confidence interval.
+ */
+void steady_estimate(SteadyMetric *m) {
+    m->valid = 0;
+    if (m->batches < MIN_MSER_BATCHES) {
+        return;
+    }
+    
+    int d = mser_truncation(m);
+    if (d < 0) {
+        return;
+    }
+    
+    int per_batch = (m->batches - d) / CI_BATCHES;
+    if (per_batch < 1) {
+        return;
+    }
+    
+    // Leftover batches are dropped from the front to stay in steady state
+    int start = m->batches - per_batch * CI_BATCHES;
+    double means[CI_BATCHES];
+    double grand = 0.0;
+    for (int b = 0; b < CI_BATCHES; b++) {
+        double sum = 0.0;
+        for (int i = 0; i < per_batch; i++) {
+            sum += m->batch_means[start + b * per_batch + i];
+        }
+        means[b] = sum / per_batch;
+        grand += means[b];
+    }
+    grand /= CI_BATCHES;
+    
+    double var = 0.0;
+    for (int b = 0; b < CI_BATCHES; b++) {
+        var += (means[b] - grand) * (means[b] - grand);
+    }
+    var /= CI_BATCHES - 1;
+    
+    m->truncation = d;
+    m->mean = grand;
+    m->half_width = t_quantile_975(CI_BATCHES - 1) * sqrt(var / CI_BATCHES);
+    m->valid = 1;
+}
+
+/**
+ * Check whether every selected metric has reached the target CI width
+ */
+int steady_state_converged(SimContext *ctx) {
+    for (int i = 0; i < NUM_STEADY_METRICS; i++) {
+        if (!(steady_metric_mask & (1u << i))) {
+            continue;
+        }
+        SteadyMetric *m = &ctx->steady[i];
+        if (!m->valid || m->mean <= 0.0 ||
+            m->half_width / m->mean > ci_target_width) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Record one observation of a steady-state metric
+ * Returns 1 if the run may stop because all selected metrics converged.
+ * Convergence is re-tested every time the batch count grows by ~5%,
+ * keeping the amortized cost per observation constant.
+ */
+int steady_record(SimContext *ctx, SteadyMetricId id, double value) {
+    if (!steady_state_enabled) {
+        return 0;
+    }
+    
+    SteadyMetric *m = &ctx->steady[id];
+    m->observations++;
+    m->partial_sum += value;
+    if (++m->partial_count < MSER_BATCH_SIZE) {
+        return 0;
+    }
+    
+    if (m->batches == m->capacity) {
+        int new_capacity = m->capacity ? m->capacity * 2 : 256;
+        double *grown = realloc(m->batch_means, sizeof(double) * new_capacity);
+        if (grown == NULL) {
+            perror("Error allocating steady-state batches");
+            return 0;
+        }
+        m->batch_means = grown;
+        m->capacity = new_capacity;
+    }
+    m->batch_means[m->batches++] = m->partial_sum / MSER_BATCH_SIZE;
+    m->partial_sum = 0.0;
+    m->partial_count = 0;
+    
+    if (m->batches < m->next_check || !(steady_metric_mask & (1u << id))) {
+        return 0;
+    }
+    m->next_check = m->batches + (m->batches / 20 > 10 ? m->batches / 20 : 10);
+    
+    steady_estimate(m);
+    return steady_state_converged(ctx);
+}
+
+/**
+ * Print the steady-state report after the run
+ */
+void print_steady_state_report(SimContext *ctx) {
+    printf("\n=== Steady-State Report ===\n");
+    if (ctx->steady_stopped_early) {
+        printf("Stopped early at clock %d: all CIs within %.1f%% of the mean\n",
+               ctx->stop_clock, ci_target_width * 100.0);
+    } else {
+        printf("Ran to completion at clock %d (target %.1f%% not reached early)\n",
+               ctx->stop_clock, ci_target_width * 100.0);
+    }
+    printf("%-12s %10s %12s %12s %14s %10s\n",
+           "Metric", "Obs", "Warm-up obs", "Mean (ms)", "95% CI +/-", "Rel. width");
+    
+    for (int i = 0; i < NUM_STEADY_METRICS; i++) {
+        if (!(steady_metric_mask & (1u << i))) {
+            continue;
+        }
+        SteadyMetric *m = &ctx->steady[i];
+        steady_estimate(m);
+        if (!m->valid) {
+            printf("%-12s %10ld %12s %12s %14s %10s\n",
+                   steady_metric_names[i], m->observations, "-", "-", "-", "n/a");
+            continue;
+        }
+        printf("%-12s %10ld %12ld %12.3f %14.3f %9.2f%%\n",
+               steady_metric_names[i], m->observations,
+               (long)m->truncation * MSER_BATCH_SIZE, m->mean, m->half_width,
+               m->mean > 0.0 ? 100.0 * m->half_width / m->mean : 0.0);
+    }
+}
+
+/* ============================================================================
+ * CHECKPOINTS
+ * ============================================================================ */
+
+/**
+ * Snapshot of a virtual-time run at the end of one tick
+ * Queues are stored as index lists so the snapshot holds no pointers.
+ */
+typedef struct Checkpoint {
+    int clock;
+    int next_arrival;
+    int terminated_count;
+    int running;                    // Index of the running process, -1 if idle
+    int running_until;
+    int last_aging_check;
+    long busy_time;
+    int ready_count;
+    int waiting_count;
+    int *ready_order;               // Ready queue, head first
+    int *waiting_order;             // Waiting queue, head first
+    Process *processes;             // Copy of every PCB (next is NULL)
+} Checkpoint;
+
+/**
+ * Periodic checkpoints of one run
+ */
+typedef struct CheckpointLog {
+    int interval;                   // Clock distance between checkpoints (ms)
+    int total_processes;
+    Checkpoint *items;
+    int count;
+    int capacity;
+    Checkpoint final;               // State when the run ended
+} CheckpointLog;
+
+void checkpoint_free(Checkpoint *cp) {
+    free(cp->ready_order);
+    free(cp->waiting_order);
+    free(cp->processes);
+    memset(cp, 0, sizeof(*cp));
+}
+
+void checkpoint_log_free(CheckpointLog *log) {
+    for (int i = 0; i < log->count; i++) {
+        checkpoint_free(&log->items[i]);
+    }
+    free(log->items);
+    checkpoint_free(&log->final);
+    memset(log, 0, sizeof(*log));
+}
+
+static int queue_to_indices(SimContext *ctx, Queue *q, int **out) {
+    *out = malloc(sizeof(int) * (q->size > 0 ? q->size : 1));
+    if (*out == NULL) {
+        return -1;
+    }
+    int n = 0;
+    for (Process *p = q->head; p != NULL; p = p->next) {
+        (*out)[n++] = (int)(p - ctx->processes);
+    }
+    return n;
+}
+
+/**
+ * Capture the current state of a context
+ */
+int checkpoint_capture(SimContext *ctx, Checkpoint *cp) {
+    memset(cp, 0, sizeof(*cp));
+    cp->clock = ctx->current_clock;
+    cp->next_arrival = ctx->next_arrival;
+    cp->terminated_count = ctx->terminated_count;
+    Core *core = &ctx->cores[0];      // Checkpointed runs have a single core
+    cp->running = core->running_process ? (int)(core->running_process - ctx->processes) : -1;
+    cp->running_until = core->running_until;
+    cp->last_aging_check = ctx->last_aging_check;
+    cp->busy_time = ctx->busy_time;
+    
+    cp->processes = malloc(sizeof(Process) * ctx->total_processes);
+    cp->ready_count = queue_to_indices(ctx, &core->ready_queue, &cp->ready_order);
+    cp->waiting_count = queue_to_indices(ctx, &ctx->waiting_queue, &cp->waiting_order);
+    if (cp->processes == NULL || cp->ready_count < 0 || cp->waiting_count < 0) {
+        perror("Error allocating checkpoint");
+        checkpoint_free(cp);
+        return -1;
+    }
+    
+    memcpy(cp->processes, ctx->processes, sizeof(Process) * ctx->total_processes);
+    for (int i = 0; i < ctx->total_processes; i++) {
+        cp->processes[i].next = NULL;
+    }
+    return 0;
+}
+
+/**
+ * Append a checkpoint of the current state to the log
+ */
+int checkpoint_log_add(CheckpointLog *log, SimContext *ctx) {
+    if (log->count == log->capacity) {
+        int new_capacity = log->capacity ? log->capacity * 2 : 64;
+        Checkpoint *grown = realloc(log->items, sizeof(Checkpoint) * new_capacity);
+        if (grown == NULL) {
+            perror("Error allocating checkpoint log");
+            return -1;
+        }
+        log->items = grown;
+        log->capacity = new_capacity;
+    }
+    if (checkpoint_capture(ctx, &log->items[log->count]) != 0) {
+        return -1;
+    }
+    log->count++;
+    return 0;
+}
+
+/**
+ * Fields that determine how a PCB evolves; per-process statistics
+ * (arrival_clock, ready_since, total_wait, ...) are deliberately excluded
+ */
+static int same_dynamics(const Process *a, const Process *b) {
+    return a->pid == b->pid &&
+           a->arrival_time == b->arrival_time &&
+           a->cpu_execution_time == b->cpu_execution_time &&
+           a->remaining_time == b->remaining_time &&
+           a->interval_time == b->interval_time &&
+           a->io_time == b->io_time &&
+           a->priority == b->priority &&
+           a->original_priority == b->original_priority &&
+           a->state == b->state &&
+           a->time_in_ready_queue == b->time_in_ready_queue &&
+           a->io_completion_time == b->io_completion_time &&
+           a->has_arrived == b->has_arrived;
+}
+
+/**
+ * Same six input fields?
+ */
+static int same_input(const Process *a, const Process *b) {
+    return a->pid == b->pid &&
+           a->arrival_time == b->arrival_time &&
+           a->cpu_execution_time == b->cpu_execution_time &&
+           a->interval_time == b->interval_time &&
+           a->io_time == b->io_time &&
+           a->original_priority == b->original_priority;
+}
+
+/**
+ * PID to array index lookup, built once per process array
+ */
+typedef struct {
+    int pid;
+    int index;
+} PidIndex;
+
+static int compare_pid_index(const void *a, const void *b) {
+    const PidIndex *x = (const PidIndex *)a, *y = (const PidIndex *)b;
+    return (x->pid > y->pid) - (x->pid < y->pid);
+}
+
+/**
+ * Build a sorted PID index; returns NULL if PIDs are not unique
+ */
+PidIndex* build_pid_index(const Process *processes, int n) {
+    PidIndex *map = malloc(sizeof(PidIndex) * (n > 0 ? n : 1));
+    if (map == NULL) {
+        perror("Error allocating PID index");
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        map[i].pid = processes[i].pid;
+        map[i].index = i;
+    }
+    qsort(map, n, sizeof(PidIndex), compare_pid_index);
+    for (int i = 1; i < n; i++) {
+        if (map[i].pid == map[i - 1].pid) {
+            fprintf(stderr, "Error: Duplicate PID %d in workload\n", map[i].pid);
+            free(map);
+            return NULL;
+        }
+    }
+    return map;
+}
+
+int pid_lookup(const PidIndex *map, int n, int pid) {
+    PidIndex key = { pid, 0 };
+    PidIndex *found = bsearch(&key, map, n, sizeof(PidIndex), compare_pid_index);
+    return found ? found->index : -1;
+}
+
+/**
+ * Baseline a re-simulation is compared against at every checkpoint
+ */
+typedef struct ConvergenceTarget {
+    const CheckpointLog *log;
+    const PidIndex *base_pids;      // PID index of the baseline processes
+    const PidIndex *edit_pids;      // PID index of the edited processes
+    int next;                       // Next baseline checkpoint to compare
+    const Checkpoint *matched;      // Checkpoint the run converged on
+} ConvergenceTarget;
+
+/**
+ * Check whether the edited run is in exactly the baseline state
+ * From then on both runs evolve identically, so simulation can stop.
+ */
+int state_matches(SimContext *ctx, const Checkpoint *cp, const ConvergenceTarget *target) {
+    int base_n = target->log->total_processes;
+    int edit_n = ctx->total_processes;
+    Core *core = &ctx->cores[0];
+    
+    if (ctx->current_clock != cp->clock || core->running_until != cp->running_until ||
+        core->ready_queue.size != cp->ready_count ||
+        ctx->waiting_queue.size != cp->waiting_count ||
+        edit_n - ctx->terminated_count != base_n - cp->terminated_count) {
+        return 0;
+    }
+    
+    int running_pid = core->running_process ? core->running_process->pid : -1;
+    int base_running_pid = cp->running >= 0 ? cp->processes[cp->running].pid : -1;
+    if (running_pid != base_running_pid) {
+        return 0;
+    }
+    
+    int i = 0;
+    for (Process *p = core->ready_queue.head; p != NULL; p = p->next, i++) {
+        if (p->pid != cp->processes[cp->ready_order[i]].pid) {
+            return 0;
+        }
+    }
+    i = 0;
+    for (Process *p = ctx->waiting_queue.head; p != NULL; p = p->next, i++) {
+        if (p->pid != cp->processes[cp->waiting_order[i]].pid) {
+            return 0;
+        }
+    }
+    
+    // Every live baseline process must be live and identical in the edited run;
+    // equal live counts then rule out extra live edited processes
+    for (int j = 0; j < base_n; j++) {
+        const Process *b = &cp->processes[j];
+        if (b->state == STATE_TERMINATED) {
+            continue;
+        }
+        int e = pid_lookup(target->edit_pids, edit_n, b->pid);
+        if (e < 0 || !same_dynamics(&ctx->processes[e], b)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ============================================================================
+ * FREQUENCY SCALING
+ * ============================================================================ */
+
+static int compare_int_desc(const void *a, const void *b) {
+    return compare_int(b, a);
+}
+
+/**
+ * Parse a --freqs list of frequency levels in MHz ("2400,1800,1200")
+ */
+int parse_freqs(const char *list) {
+    const char *c = list;
+    freq_count = 0;
+    while (*c) {
+        char *end;
+        long mhz = strtol(c, &end, 10);
+        if (end == c || (*end != ',' && *end != '\0') || mhz < 1 || mhz > 100000 ||
+            freq_count == MAX_FREQ_LEVELS) {
+            return -1;
+        }
+        freq_levels[freq_count++] = (int)mhz;
+        c = *end == ',' ? end + 1 : end;
+    }
+    qsort(freq_levels, freq_count, sizeof(int), compare_int_desc);
+    return freq_count > 0 ? 0 : -1;
+}
+
+/**
+ * Wall-clock length of a burst of work ms (measured at the top frequency)
+ * on a core running at level
+ */
+static inline int dvfs_scale(int work, int level) {
+    if (freq_count == 0) {
+        return work;
+    }
+    return (int)(((long)work * freq_levels[0] + freq_levels[level] - 1) / freq_levels[level]);
+}
+
+/**
+ * Power drawn by a busy core at level: dynamic power scales with f^3
+ * (voltage tracks frequency) on top of the idle floor
+ */
+static double level_watts(int level) {
+    double f = (double)freq_levels[level] / freq_levels[0];
+    return idle_watts + (active_watts - idle_watts) * f * f * f;
+}
+
+/**
+ * Busy time a core has actually executed by clock
+ */
+static long core_executed(const Core *core, int clock) {
+    if (core->running_process == NULL || clock >= core->running_until) {
+        return core->busy_time;
+    }
+    int start = clock > core->burst_start ? clock : core->burst_start;
+    return core->busy_time - (core->running_until - start);
+}
+
+/**
+ * Set every core to the governor's fixed level and arm the ondemand timer
+ */
+void dvfs_setup(SimContext *ctx) {
+    int level = governor == GOVERNOR_POWERSAVE ? freq_count - 1 : 0;
+    for (int c = 0; c < ctx->num_cores; c++) {
+        ctx->cores[c].level = level;
+        ctx->cores[c].window_mark = 0;
+    }
+    if (governor == GOVERNOR_ONDEMAND) {
+        timer_push(&ctx->timers, governor_window, TIMER_GOVERNOR, 0);
+        ctx->periodic_timers++;
+    }
+}
+
+/**
+ * Ondemand governor: jump to the top level above the up threshold, else
+ * pick the slowest level that would keep utilization under it
+ * Only bursts dispatched after a change run at the new frequency.
+ */
+void governor_update(SimContext *ctx, int clock) {
+    for (int c = 0; c < ctx->num_cores; c++) {
+        Core *core = &ctx->cores[c];
+        long executed = core_executed(core, clock);
+        double util = (double)(executed - core->window_mark) / governor_window;
+        core->window_mark = executed;
+        if (util < 0) {
+            util = 0;  // A noise hit pushed back work counted in the last window
+        }
+        
+        // Busy time at the current level, as a share of the top frequency
+        double demand = util * freq_levels[core->level] / ONDEMAND_UP_THRESHOLD;
+        int level = 0;
+        if (util < ONDEMAND_UP_THRESHOLD) {
+            level = freq_count - 1;
+            while (level > 0 && freq_levels[level] < demand) {
+                level--;
+            }
+        }
+        if (level != core->level) {
+            sim_log(ctx, "[Clock: %d] Core %d frequency %d -> %d MHz (utilization %.2f)\n",
+                    clock, c, freq_levels[core->level], freq_levels[level], util);
+            core->level = level;
+            ctx->freq_changes++;
+        }
+    }
+    timer_push(&ctx->timers, clock + governor_window, TIMER_GOVERNOR, 0);
+}
+
+/* ============================================================================
+ * SMT SIBLINGS
+ * ============================================================================ */
+
+/**
+ * Bring a core's burst progress up to clock at its current rate
+ */
+static void smt_sync(Core *core, int clock) {
+    if (clock > core->work_mark) {
+        core->work_left -= (clock - core->work_mark) * core->rate;
+        core->work_mark = clock;
+        if (core->work_left < 0) {
+            core->work_left = 0;
+        }
+    }
+}
+
+/**
+ * Re-time a core's burst for its sibling's current state
+ * Called only when the sibling starts or stops, so a burst is recomputed
+ * once per change rather than on every tick. Gang bursts keep their
+ * length so that all of their cores finish together.
+ */
+static void smt_retime(SimContext *ctx, Core *core, int clock) {
+    Process *p = core->running_process;
+    if (p == NULL || p->threads > 1 || clock >= core->running_until) {
+        return;
+    }
+    Core *sibling = smt_sibling(ctx, core);
+    double rate = sibling != NULL && sibling->running_process != NULL ? 1.0 / ctx->smt_factor : 1.0;
+    if (rate == core->rate) {
+        return;
+    }
+    smt_sync(core, clock);
+    core->rate = rate;
+    
+    int until = core->work_mark + (int)ceil(core->work_left / rate - 1e-9);
+    if (until <= clock) {
+        until = clock + 1;
+    }
+    int delta = until - core->running_until;
+    core->running_until = until;
+    core->busy_time += delta;
+    ctx->busy_time += delta;
+    ctx->level_busy[core->burst_level] += delta;
+    ctx->smt_stretch += delta;
+    core_refresh(ctx, core);
+}
+
+/**
+ * A core started or stopped running: track co-running time and re-time
+ * both bursts of the pair
+ */
+void smt_changed(SimContext *ctx, Core *core, int clock) {
+    Core *sibling = smt_sibling(ctx, core);
+    if (sibling == NULL) {
+        return;
+    }
+    Core *even = core < sibling ? core : sibling;
+    int both = core->running_process != NULL && sibling->running_process != NULL;
+    if (both && even->corun_since < 0) {
+        even->corun_since = clock;
+    } else if (!both && even->corun_since >= 0) {
+        ctx->corun_time += clock - even->corun_since;
+        even->corun_since = -1;
+    }
+    
+    smt_retime(ctx, core, clock);
+    smt_retime(ctx, sibling, clock);
+    core_refresh(ctx, sibling);  // Placement keys depend on the sibling
+}
+
+/**
+ * Record the solo length of a burst that just started on a core
+ */
+static void smt_begin(SimContext *ctx, Core *core, int clock) {
+    core->burst_noise = 0;
+    core->burst_work = burst_length(core->running_process);
+    core->burst_wall = core->running_until - core->burst_start;
+    core->work_left = core->burst_wall;
+    core->work_mark = core->burst_start;
+    core->rate = 1.0;
+    smt_changed(ctx, core, clock);
+}
+
+/**
+ * Mark every pair idle before the run
+ */
+void smt_setup(SimContext *ctx) {
+    for (int c = 0; c < ctx->num_cores; c++) {
+        ctx->cores[c].corun_since = -1;
+        ctx->cores[c].rate = 1.0;
+    }
+}
+
+/**
+ * Print how much the siblings got in each other's way
+ */
+void print_smt_report(SimContext *ctx) {
+    long corun = ctx->corun_time;
+    for (int c = 0; c + 1 < ctx->num_cores; c += 2) {
+        if (ctx->cores[c].corun_since >= 0) {
+            corun += ctx->stop_clock - ctx->cores[c].corun_since;
+        }
+    }
+    int pairs = ctx->num_cores / 2;
+    double pair_time = (double)ctx->stop_clock * pairs;
+    
+    printf("\n=== SMT Report ===\n");
+    printf("Sibling pairs: %d, slowdown %.2fx, placement %s\n",
+           pairs, ctx->smt_factor, smt_place_names[ctx->smt_place]);
+    printf("Both siblings busy: %ld ms (%.2f%% of pair time)\n",
+           corun, pair_time > 0 ? 100.0 * corun / pair_time : 0.0);
+    printf("Burst time added by interference: %ld ms (%.2f%% of busy time)\n", ctx->smt_stretch,
+           ctx->busy_time > 0 ? 100.0 * ctx->smt_stretch / ctx->busy_time : 0.0);
+}
+
+/* ============================================================================
+ * NOISE
+ * ============================================================================ */
+
+/**
+ * Parse a --noise spec "periodic:PERIOD/DURATION" or "poisson:MEAN/DURATION"
+ * (ms), optionally "@CORE" to hit one core only
+ */
+int parse_noise_spec(const char *spec) {
+    NoiseSource src;
+    const char *rest;
+    if (strncmp(spec, "periodic:", 9) == 0) {
+        src.poisson = 0;
+        rest = spec + 9;
+    } else if (strncmp(spec, "poisson:", 8) == 0) {
+        src.poisson = 1;
+        rest = spec + 8;
+    } else {
+        return -1;
+    }
+    
+    int used = 0;
+    src.core = -1;
+    if (noise_count == MAX_NOISE_SOURCES ||
+        sscanf(rest, "%lf/%d%n", &src.interval, &src.duration, &used) != 2) {
+        return -1;
+    }
+    rest += used;
+    if (*rest == '@') {
+        char *end;
+        src.core = (int)strtol(rest + 1, &end, 10);
+        if (end == rest + 1 || src.core < 0 || src.core >= MAX_CORES) {
+            return -1;
+        }
+        rest = end;
+    }
+    if (*rest != '\0' || src.interval < 1.0 || src.duration < 1) {
+        return -1;
+    }
+    noise_sources[noise_count++] = src;
+    return 0;
+}
+
+/**
+ * Schedule the next hit of a source on a core
+ */
+static void noise_arm(SimContext *ctx, int source, int core, int clock) {
+    const NoiseSource *src = &noise_sources[source];
+    double gap = src->poisson ? rng_exponential(&ctx->noise_rng, src->interval) : src->interval;
+    int when = clock + (gap < 1.0 ? 1 : (int)(gap + 0.5));
+    timer_push(&ctx->timers, when, TIMER_NOISE, source * MAX_CORES + core);
+}
+
+/**
+ * Arm every source on the cores it hits
+ */
+void noise_setup(SimContext *ctx) {
+    for (int n = 0; n < noise_count; n++) {
+        for (int c = 0; c < ctx->num_cores; c++) {
+            if (noise_sources[n].core < 0 || noise_sources[n].core == c) {
+                noise_arm(ctx, n, c, 0);
+                ctx->periodic_timers++;
+            }
+        }
+    }
+}
+
+/**
+ * A noise hit: the running burst loses the core for the hit's duration,
+ * so it ends that much later. All cores of a gang wait for the one hit.
+ * The core stays busy at the burst's level while the noise runs, so the
+ * stolen time counts as busy time and active energy.
+ */
+void noise_hit(SimContext *ctx, int id, int clock) {
+    int source = id / MAX_CORES;
+    Core *core = &ctx->cores[id % MAX_CORES];
+    int duration = noise_sources[source].duration;
+    noise_arm(ctx, source, id % MAX_CORES, clock);
+    
+    Process *p = core->running_process;
+    if (p == NULL || clock >= core->running_until) {
+        ctx->noise_idle_hits++;
+        return;
+    }
+    ctx->noise_hits++;
+    ctx->noise_stolen += duration;
+    
+    for (int c = 0; c < ctx->num_cores; c++) {
+        Core *other = &ctx->cores[c];
+        if (other != core && (p->threads == 1 || other->running_process != p)) {
+            continue;
+        }
+        // Progress pauses for the stolen time
+        if (ctx->smt_factor > 0) {
+            smt_sync(other, clock);
+            other->work_mark = (other->work_mark > clock ? other->work_mark : clock) + duration;
+        }
+        if (other->burst_start <= clock) {
+            other->burst_start += duration;
+        }
+        other->running_until += duration;
+        other->burst_noise += duration;
+        other->busy_time += duration;
+        ctx->busy_time += duration;
+        ctx->noise_busy += duration;
+        ctx->level_busy[other->burst_level] += duration;
+        core_refresh(ctx, other);
+    }
+}
+
+/**
+ * Account the stolen time of a burst that just completed
+ */
+static void noise_burst_done(SimContext *ctx, Core *core) {
+    int stolen = core->burst_noise < MAX_BURST_NOISE ? core->burst_noise : MAX_BURST_NOISE;
+    ctx->burst_noise_hist[stolen]++;
+    ctx->noisy_bursts++;
+}
+
+/**
+ * Stolen time below which a fraction q of the bursts fall
+ */
+static int burst_noise_quantile(const SimContext *ctx, double q) {
+    long target = (long)(q * (ctx->noisy_bursts - 1));
+    long seen = 0;
+    for (int ms = 0; ms <= MAX_BURST_NOISE; ms++) {
+        seen += ctx->burst_noise_hist[ms];
+        if (seen > target) {
+            return ms;
+        }
+    }
+    return MAX_BURST_NOISE;
+}
+
+/**
+ * Print stolen time and the delay it added to bursts and processes
+ */
+void print_noise_report(SimContext *ctx) {
+    int n = 0;
+    int *turnarounds = malloc(sizeof(int) * (ctx->total_processes > 0 ? ctx->total_processes : 1));
+    for (int i = 0; turnarounds != NULL && i < ctx->total_processes; i++) {
+        const Process *p = &ctx->processes[i];
+        if (p->completion_clock >= 0) {
+            turnarounds[n++] = p->completion_clock - p->arrival_clock;
+        }
+    }
+    
+    double capacity = (double)ctx->stop_clock * ctx->num_cores;
+    printf("\n=== Noise Report ===\n");
+    printf("Hits on running bursts: %ld (%ld more on idle cores)\n",
+           ctx->noise_hits, ctx->noise_idle_hits);
+    printf("CPU stolen: %ld core-ms (%.2f%% of capacity)\n", ctx->noise_stolen,
+           capacity > 0 ? 100.0 * ctx->noise_stolen / capacity : 0.0);
+    if (ctx->noisy_bursts > 0) {
+        printf("Delay per burst (ms): p50 %d, p95 %d, p99 %d, max %d over %ld bursts\n",
+               burst_noise_quantile(ctx, 0.50), burst_noise_quantile(ctx, 0.95),
+               burst_noise_quantile(ctx, 0.99), burst_noise_quantile(ctx, 1.0), ctx->noisy_bursts);
+    }
+    if (n > 0) {
+        qsort(turnarounds, n, sizeof(int), compare_int);
+        printf("Turnaround (ms): p50 %d, p95 %d, p99 %d, max %d\n",
+               turnarounds[(int)(0.50 * (n - 1))], turnarounds[(int)(0.95 * (n - 1))],
+               turnarounds[(int)(0.99 * (n - 1))], turnarounds[n - 1]);
+    }
+    free(turnarounds);
+}
+
+/* ============================================================================
+ * MEMORY
+ * ============================================================================ */
+
+/**
+ * Thrashing slowdown for the current resident set: the share of the
+ * working sets that does not fit is paged, and each paged share costs
+ * --thrash-penalty times its CPU time
+ */
+static double mem_slowdown(const SimContext *ctx) {
+    if (memory_capacity == 0 || ctx->resident <= memory_capacity) {
+        return 1.0;
+    }
+    return 1.0 + thrash_penalty * (1.0 - (double)memory_capacity / ctx->resident);
+}
+
+/**
+ * Stretch a burst by the current slowdown
+ */
+static int mem_scale(SimContext *ctx, int wall) {
+    if (memory_capacity == 0) {
+        return wall;
+    }
+    double slowdown = mem_slowdown(ctx);
+    ctx->slowdown_sum += slowdown;
+    ctx->slowed_bursts++;
+    return (int)ceil(wall * slowdown - 1e-9);
+}
+
+/**
+ * Change the resident set, integrating it over time
+ */
+static void mem_account(SimContext *ctx, long delta, int clock) {
+    ctx->resident_integral += (double)ctx->resident * (clock - ctx->resident_mark);
+    if (ctx->resident > memory_capacity) {
+        ctx->overcommit_time += clock - ctx->resident_mark;
+    }
+    ctx->resident_mark = clock;
+    ctx->resident += delta;
+    if (ctx->resident > ctx->peak_resident) {
+        ctx->peak_resident = ctx->resident;
+    }
+}
+
+/**
+ * Make an arriving process resident; returns 0 if admission holds it
+ * Admission is first come, first served, and a process larger than memory
+ * is admitted once nothing else is resident.
+ */
+int mem_reserve(SimContext *ctx, Process *p, int clock) {
+    if (mem_admission && (!is_empty(&ctx->mem_waiting) ||
+                          (ctx->resident > 0 && ctx->resident + p->mem > memory_capacity))) {
+        ctx->mem_holds++;
+        sim_log(ctx, "[Clock: %d] PID %d held: %d MB does not fit (%ld of %ld MB resident)\n",
+                clock, p->pid, p->mem, ctx->resident, memory_capacity);
+        enqueue(&ctx->mem_waiting, p);
+        return 0;
+    }
+    mem_account(ctx, p->mem, clock);
+    return 1;
+}
+
+/**
+ * Next held arrival that fits after memory was freed, made resident; NULL
+ * if the head of the line still does not fit
+ */
+Process* mem_admit_next(SimContext *ctx, int clock) {
+    Process *head = ctx->mem_waiting.head;
+    if (head == NULL || (ctx->resident > 0 && ctx->resident + head->mem > memory_capacity)) {
+        return NULL;
+    }
+    dequeue(&ctx->mem_waiting);
+    ctx->mem_hold_time += clock - head->arrival_clock;
+    mem_account(ctx, head->mem, clock);
+    return head;
+}
+
+/**
+ * Print resident set, overcommit and the slowdown it caused
+ */
+void print_memory_report(SimContext *ctx) {
+    mem_account(ctx, 0, ctx->stop_clock);
+    printf("\n=== Memory Report (%s) ===\n", mem_admission ? "admission" : "no admission");
+    printf("Capacity: %ld MB, peak resident %ld MB, mean resident %.1f MB\n", memory_capacity,
+           ctx->peak_resident, ctx->stop_clock > 0 ? ctx->resident_integral / ctx->stop_clock : 0.0);
+    printf("Overcommitted: %ld ms (%.2f%% of the run)\n", ctx->overcommit_time,
+           ctx->stop_clock > 0 ? 100.0 * ctx->overcommit_time / ctx->stop_clock : 0.0);
+    printf("Mean burst slowdown: %.3fx over %ld bursts\n",
+           ctx->slowed_bursts > 0 ? ctx->slowdown_sum / ctx->slowed_bursts : 1.0, ctx->slowed_bursts);
+    printf("Admission holds: %ld, mean hold %.1f ms\n", ctx->mem_holds,
+           ctx->mem_holds > 0 ? (double)ctx->mem_hold_time / ctx->mem_holds : 0.0);
+    printf("Throughput: %.3f processes/s\n",
+           ctx->stop_clock > 0 ? 1000.0 * ctx->terminated_count / ctx->stop_clock : 0.0);
+}
+
+/* ============================================================================
+ * SCHEDULER
+ * ============================================================================ */
+
+/**
+ * Admit an arriving process into the ready queue
+ */
+static void start_process(SimContext *ctx, Process *p, int clock);
+
+static void admit_process(SimContext *ctx, Process *p, int clock) {
+    p->has_arrived = 1;
+    p->arrival_clock = clock;
+    
+    sim_log(ctx, "[Clock: %d] PID %d arrived\n", clock, p->pid);
+    hook_fire(SCHED_HOOK_ARRIVAL, p, clock);
+    
+    if (memory_capacity > 0 && !mem_reserve(ctx, p, clock)) {
+        return;
+    }
+    start_process(ctx, p, clock);
+}
+
+/**
+ * Move an admitted process into the ready queue and start its threads
+ */
+static void start_process(SimContext *ctx, Process *p, int clock) {
+    p->ready_since = clock;
+    p->state = STATE_READY;
+    make_ready(ctx, p);
+    
+    sim_log(ctx, "[Clock: %d] PID %d moved to READY queue\n", clock, p->pid);
+    if (p->workers > 1) {
+        spawn_threads(ctx, p, clock);
+    }
+}
+
+/**
+ * Free a finished job's working set and start the held arrivals that now fit
+ */
+static void mem_release(SimContext *ctx, Process *p, int clock) {
+    mem_account(ctx, -p->mem, clock);
+    Process *admitted;
+    while ((admitted = mem_admit_next(ctx, clock)) != NULL) {
+        start_process(ctx, admitted, clock);
+    }
+}
+
+/**
+ * Closed system: draw a think time, rounded to the nearest ms and at least 1
+ * Used for every job of a user, first and later alike.
+ */
+static int think_time(Rng *rng, double mean) {
+    int think = (int)(rng_exponential(rng, mean) + 0.5);
+    return think > 0 ? think : 1;
+}
+
+/**
+ * Closed system: account the finished job and reuse its PCB in place
+ * for the user's next job after an exponential think time
+ */
+static void recycle_closed_job(SimContext *ctx, Process *p, int clock) {
+    int response = clock - p->arrival_clock;
+    ctx->jobs_completed++;
+    ctx->response_sum += response;
+    ctx->response_sq_sum += (double)response * response;
+    if (response > ctx->response_max) {
+        ctx->response_max = response;
+    }
+    if (memory_capacity > 0) {
+        mem_release(ctx, p, clock);
+    }
+    
+    int think = think_time(&ctx->rng, ctx->think_mean);
+    p->state = STATE_NEW;
+    p->has_arrived = 0;
+    p->remaining_time = p->cpu_execution_time;
+    p->priority = p->original_priority;
+    p->arrival_time = clock + think;
+    p->first_dispatch_clock = -1;
+    p->total_wait = 0;
+    timer_push(&ctx->timers, p->arrival_time, TIMER_ARRIVAL, (int)(p - ctx->processes));
+}
+
+/**
+ * Start a new capacity segment at clock
+ */
+static void capacity_segment(SimContext *ctx, int clock, int moved) {
+    CapacitySegment *seg = &ctx->segments[ctx->segment_count++];
+    seg->start = clock;
+    seg->online = ctx->num_cores - ctx->offline_cores;
+    seg->completed_before = ctx->terminated_count;
+    seg->moved = moved;
+}
+
+/**
+ * Take the running process off a core before its burst ends
+ * It is charged for the CPU time used, the unused part of the burst is no
+ * longer counted as busy, and it rejoins a ready queue. A gang job leaves
+ * all of its cores. Returns 1 if a process was preempted.
+ */
+static int core_preempt(SimContext *ctx, Core *core, int clock) {
+    Process *p = core->running_process;
+    if (p == NULL || clock >= core->running_until) {
+        return 0;  // The burst completes this tick anyway
+    }
+    // A core still waking up has not started the burst
+    int ran_wall = clock > core->burst_start ? clock - core->burst_start : 0;
+    int unused = core->running_until - core->burst_start - ran_wall;
+    int progress = ran_wall;
+    if (ctx->smt_factor > 0 && p->threads == 1) {
+        // Progress depends on how long the sibling was busy
+        smt_sync(core, clock);
+        progress = (int)(core->burst_wall - core->work_left);
+    }
+    // Work done is the executed share of the burst, whatever stretched it
+    int ran = core->burst_wall > 0 ? (int)((long)core->burst_work * progress / core->burst_wall) : 0;
+    
+    for (int c = 0; c < ctx->num_cores; c++) {
+        Core *other = &ctx->cores[c];
+        if (other->running_process == p) {
+            other->running_process = NULL;
+            other->running_until = clock;  // Idle from now
+            other->busy_time -= unused;
+            ctx->busy_time -= unused;
+            ctx->level_busy[other->burst_level] -= unused;
+            core_refresh(ctx, other);
+            smt_changed(ctx, other, clock);
+        }
+    }
+    p->gang_leader = -1;
+    p->remaining_time -= ran;
+    group_charge(ctx, p, ran, clock);
+    
+    sim_log(ctx, "[Clock: %d] PID %d preempted after %d ms\n", clock, p->pid, ran);
+    p->state = STATE_READY;
+    p->ready_since = clock;
+    make_ready(ctx, p);
+    return 1;
+}
+
+/**
+ * Take a core offline: preempt its process and hand its whole ready queue
+ * to the online cores, at a cost proportional to that queue
+ */
+static void core_offline(SimContext *ctx, int c, int clock) {
+    Core *core = &ctx->cores[c];
+    if (core->offline) {
+        return;
+    }
+    if (ctx->offline_cores == ctx->num_cores - 1) {
+        sim_log(ctx, "[Clock: %d] Core %d stays online: it is the last one\n", clock, c);
+        return;
+    }
+    core->offline = 1;
+    ctx->offline_cores++;
+    
+    // Detach the queue in one step, then place each process
+    Queue moved;
+    init_queue(&moved);
+    if (ctx->policy != POLICY_SRTF) {
+        for (int i = 0; i < core->heap_size; i++) {
+            core->heap[i]->heap_pos = -1;
+            enqueue(&moved, core->heap[i]);
+        }
+        core->heap_size = 0;
+    } else {
+        moved = core->ready_queue;
+        init_queue(&core->ready_queue);
+    }
+    ctx->ready_total -= moved.size;
+    core->queued_work = 0;
+    core_refresh(ctx, core);
+    
+    int preempted = core_preempt(ctx, core, clock);
+    int count = moved.size;
+    while (!is_empty(&moved)) {
+        Process *p = dequeue(&moved);
+        p->core = -1;
+        make_ready(ctx, p);
+    }
+    
+    sim_log(ctx, "[Clock: %d] Core %d offline: %d process(es) moved\n", clock, c, count + preempted);
+    capacity_segment(ctx, clock, count + preempted);
+}
+
+/**
+ * Bring a core back; new arrivals and I/O returns fill it
+ */
+static void core_online(SimContext *ctx, int c, int clock) {
+    Core *core = &ctx->cores[c];
+    if (!core->offline) {
+        return;
+    }
+    core->offline = 0;
+    ctx->offline_cores--;
+    core_refresh(ctx, core);
+    
+    sim_log(ctx, "[Clock: %d] Core %d online\n", clock, c);
+    capacity_segment(ctx, clock, 0);
+}
+
+/**
+ * Schedule the --offline windows of the cores this run has
+ */
+void core_events_setup(SimContext *ctx) {
+    capacity_segment(ctx, 0, 0);
+    for (int i = 0; i < core_event_count; i++) {
+        const CoreEvent *e = &core_events[i];
+        if (e->core >= ctx->num_cores) {
+            continue;
+        }
+        timer_push(&ctx->timers, e->from, TIMER_CORE_OFFLINE, e->core);
+        if (e->to >= 0) {
+            timer_push(&ctx->timers, e->to, TIMER_CORE_ONLINE, e->core);
+        }
+    }
+}
+
+/**
+ * Print throughput for each stretch of constant capacity
+ */
+void print_capacity_report(SimContext *ctx) {
+    printf("\n=== Capacity Report ===\n");
+    printf("%10s %10s %7s %7s %10s %14s\n",
+           "From (ms)", "To (ms)", "Online", "Moved", "Completed", "Throughput/s");
+    for (int i = 0; i < ctx->segment_count; i++) {
+        const CapacitySegment *seg = &ctx->segments[i];
+        int last = i + 1 == ctx->segment_count;
+        int end = last ? ctx->stop_clock : ctx->segments[i + 1].start;
+        int completed = (last ? ctx->terminated_count : ctx->segments[i + 1].completed_before) -
+                        seg->completed_before;
+        printf("%10d %10d %7d %7d %10d %14.2f\n", seg->start, end, seg->online, seg->moved,
+               completed, end > seg->start ? 1000.0 * completed / (end - seg->start) : 0.0);
+    }
+}
+
+/**
+ * Dispatch one due timer event
+ */
+static void handle_timer(SimContext *ctx, const Timer *t, int clock) {
+    switch (t->kind) {
+        case TIMER_ARRIVAL:
+            admit_process(ctx, &ctx->processes[t->id], clock);
+            break;
+        case TIMER_GROUP_REFRESH:
+            group_refresh(ctx, t->id, clock);
+            break;
+        case TIMER_CORE_OFFLINE:
+            core_offline(ctx, t->id, clock);
+            break;
+        case TIMER_CORE_ONLINE:
+            core_online(ctx, t->id, clock);
+            break;
+        case TIMER_GOVERNOR:
+            governor_update(ctx, clock);
+            break;
+        case TIMER_NOISE:
+            noise_hit(ctx, t->id, clock);
+            break;
+    }
+}
+
+/**
+ * Virtual-time fast-forward
+ * With empty ready queues nothing can change before the next arrival,
+ * burst end or I/O completion, so the clock jumps just before that event.
+ * Waiting gang jobs keep aging every tick, so they stop the jump too.
+ */
+static void skip_idle_ticks(SimContext *ctx, int clock) {
+    if (ctx->ready_total > 0 || ctx->gang_waiting > 0) {
+        return;
+    }
+    
+    int next = INT_MAX;
+    for (int c = 0; c < ctx->num_cores; c++) {
+        Core *core = &ctx->cores[c];
+        if (core->running_process != NULL && core->running_until < next) {
+            next = core->running_until;
+        }
+    }
+    if (ctx->next_arrival < ctx->total_processes) {
+        int arrival = effective_arrival(&ctx->processes[ctx->next_arrival]);
+        if (arrival < next) {
+            next = arrival;
+        }
+    }
+    if (!is_empty(&ctx->inbox) && effective_arrival(ctx->inbox.head) < next) {
+        next = effective_arrival(ctx->inbox.head);
+    }
+    for (Process *p = ctx->waiting_queue.head; p != NULL; p = p->next) {
+        if (p->io_completion_time < next) {
+            next = p->io_completion_time;
+        }
+    }
+    if (timer_next(&ctx->timers) < next) {
+        next = timer_next(&ctx->timers);
+    }
+    if (ctx->end_clock > 0 && ctx->end_clock < next) {
+        next = ctx->end_clock;
+    }
+    
+    // Land exactly on checkpoint boundaries so runs compare at equal clocks
+    if (ctx->checkpoint_interval > 0 && next > ctx->next_checkpoint) {
+        next = ctx->next_checkpoint;
+    }
+    
+    if (next != INT_MAX && next - 1 > clock) {
+        ctx->current_clock = next - 1;
+        ctx->last_aging_check = next - 1;
+    }
+}
+
+/**
+ * Checkpoint hook, called at the end of a tick on a checkpoint boundary
+ * Records the state and/or compares it with the baseline being re-simulated.
+ */
+static void sim_checkpoint(SimContext *ctx) {
+    int clock = ctx->current_clock;
+    ctx->next_checkpoint = (clock / ctx->checkpoint_interval + 1) * ctx->checkpoint_interval;
+    
+    if (ctx->checkpoints != NULL) {
+        checkpoint_log_add(ctx->checkpoints, ctx);
+    }
+    
+    ConvergenceTarget *target = ctx->converge;
+    if (target == NULL) {
+        return;
+    }
+    const CheckpointLog *log = target->log;
+    while (target->next < log->count && log->items[target->next].clock < clock) {
+        target->next++;
+    }
+    if (target->next < log->count && log->items[target->next].clock == clock &&
+        state_matches(ctx, &log->items[target->next], target)) {
+        target->matched = &log->items[target->next];
+        ctx->converged = 1;
+    }
+}
+
+/**
+ * Take the next runnable process off a core's ready queue
+ * Processes of throttled groups are moved to their group as they reach
+ * the head, O(1) each, instead of being searched for when a group throttles.
+ * While a gang job holds a reservation, a head whose burst would delay it
+ * goes back and NULL is returned. A resource user locks its resource only
+ * after that check, or blocks on it.
+ */
+static Process* core_pick(SimContext *ctx, Core *core, int clock) {
+    int held = 0;
+    Process *p = NULL;
+    while (p == NULL && core_ready_count(core) > 0) {
+        p = core_dequeue(ctx, core);
+        if (p->group >= 0 && ctx->groups[p->group].throttled) {
+            enqueue(&ctx->groups[p->group].held, p);
+            held = 1;
+            p = NULL;
+        } else if (ctx->gang_reserved && !gang_fits(ctx, burst_length(p), 1, clock)) {
+            core_enqueue(ctx, core, p);
+            return NULL;
+        } else if (p->resource >= 0 && p->held_bursts_left == 0 &&
+                   !resource_acquire(ctx, p, clock)) {
+            held = 1;
+            p = NULL;
+        }
+    }
+    if (held) {
+        core_refresh(ctx, core);
+    }
+    return p;
+}
+
+/**
+ * Account the dispatch of a ready process whose burst starts at the given
+ * clock, after any core wake-up; returns its burst length
+ */
+static int begin_burst(SimContext *ctx, Process *p, int clock) {
+    p->state = STATE_RUNNING;
+    
+    // Waits of worker threads count towards their process
+    Process *pcb = pcb_of(p);
+    int waited = clock - p->ready_since;
+    pcb->total_wait += waited;
+    if (pcb->first_dispatch_clock < 0) {
+        pcb->first_dispatch_clock = clock;
+    }
+    ctx->steady_done |= steady_record(ctx, METRIC_WAIT, waited);
+    int cls = priority_class(p->original_priority);
+    ctx->wait_by_priority[cls] += waited;
+    ctx->dispatches_by_priority[cls]++;
+    hook_fire(SCHED_HOOK_DISPATCH, p, clock);
+    
+    // Calculate actual burst time (minimum of interval_time and remaining_time)
+    return burst_length(p);
+}
+
+/**
+ * Reserve cores for a gang job that does not fit: the shadow time is when
+ * enough running bursts will have ended
+ */
+static void gang_reserve(SimContext *ctx, const Process *head, int idle) {
+    int ends[MAX_CORES];
+    int busy = 0;
+    for (int c = 0; c < ctx->num_cores; c++) {
+        if (ctx->cores[c].running_process != NULL && !ctx->cores[c].offline) {
+            ends[busy++] = ctx->cores[c].running_until;
+        }
+    }
+    qsort(ends, busy, sizeof(int), compare_int);
+    
+    ctx->gang_reserved = 1;
+    ctx->shadow_clock = ends[head->threads - idle - 1];
+    int free_then = idle;
+    for (int i = 0; i < busy && ends[i] <= ctx->shadow_clock; i++) {
+        free_then++;
+    }
+    ctx->shadow_extra = free_then - head->threads;
+}
+
+/**
+ * Start one gang burst on the first idle cores
+ */
+static void gang_start(SimContext *ctx, Process *p, int clock) {
+    int burst_time = burst_length(p);
+    
+    // The threads start together once the slowest of their cores is awake,
+    // and finish with the slowest of their frequencies
+    int cores[MAX_CORES];
+    int placed = 0, wake = 0, wall = burst_time;
+    for (int c = 0; c < ctx->num_cores && placed < p->threads; c++) {
+        Core *core = &ctx->cores[c];
+        if (core->running_process != NULL || core->offline) {
+            continue;
+        }
+        int latency = core_wake(ctx, core, clock);
+        int scaled = dvfs_scale(burst_time, core->level);
+        wake = latency > wake ? latency : wake;
+        wall = scaled > wall ? scaled : wall;
+        cores[placed++] = c;
+    }
+    if (placed == 0) {
+        // Callers check the idle count first; never start on no cores
+        gang_enqueue(ctx, p);
+        return;
+    }
+    
+    int start = clock + wake;
+    ctx->gang_dispatches[p->threads]++;
+    ctx->gang_wait[p->threads] += start - p->ready_since;
+    begin_burst(ctx, p, start);
+    wall = mem_scale(ctx, wall);
+    p->gang_leader = cores[0];
+    for (int i = 0; i < placed; i++) {
+        Core *core = &ctx->cores[cores[i]];
+        core->running_process = p;
+        core->burst_start = start;
+        core->running_until = start + wall;
+        core->burst_level = core->level;
+        core->busy_time += wall;
+        ctx->level_busy[core->level] += wall;
+        core_refresh(ctx, core);
+        smt_begin(ctx, core, clock);
+    }
+    ctx->busy_time += (long)wall * p->threads;
+    
+    sim_log(ctx, "[Clock: %d] Scheduler dispatched gang PID %d (Pr: %d, Rm: %d) on %d cores for %d ms burst\n",
+            clock, p->pid, p->priority, p->remaining_time, p->threads, burst_time);
+}
+
+/**
+ * Dispatch ready gang jobs onto idle cores
+ * The first gang job starts as soon as enough cores are idle; until then it
+ * holds a reservation, and with backfilling smaller gang jobs whose classes
+ * fit the idle cores may start if they do not delay it.
+ */
+void gang_dispatch(SimContext *ctx, int clock) {
+    ctx->gang_reserved = 0;
+    int idle = 0;
+    for (int c = 0; c < ctx->num_cores; c++) {
+        idle += ctx->cores[c].running_process == NULL && !ctx->cores[c].offline;
+    }
+    
+    // Classes wider than the online cores wait until enough come back
+    int online = ctx->num_cores - ctx->offline_cores;
+    uint64_t runnable = gang_classes_upto(online);
+    
+    Process *head;
+    while ((head = gang_head(ctx, ctx->gang_classes & runnable)) != NULL) {
+        if (head->group >= 0 && ctx->groups[head->group].throttled) {
+            enqueue(&ctx->groups[head->group].held, gang_dequeue(ctx, head->threads));
+            continue;
+        }
+        if (head->threads > idle) {
+            break;
+        }
+        gang_start(ctx, gang_dequeue(ctx, head->threads), clock);
+        idle -= head->threads;
+    }
+    if (head == NULL) {
+        return;
+    }
+    
+    gang_reserve(ctx, head, idle);
+    
+    // Backfill from the size classes that fit the idle cores
+    uint64_t fitting = gang_classes_upto(idle);
+    Process *next;
+    while ((next = gang_head(ctx, ctx->gang_classes & fitting & ~(1ull << (head->threads - 1)))) != NULL) {
+        if (next->group >= 0 && ctx->groups[next->group].throttled) {
+            enqueue(&ctx->groups[next->group].held, gang_dequeue(ctx, next->threads));
+            continue;
+        }
+        if (!gang_fits(ctx, burst_length(next), next->threads, clock)) {
+            break;
+        }
+        gang_backfill_claim(ctx, burst_length(next), next->threads, clock);
+        gang_start(ctx, gang_dequeue(ctx, next->threads), clock);
+        ctx->backfilled_gang++;
+        idle -= next->threads;
+        fitting = gang_classes_upto(idle);
+    }
+}
+
+/**
+ * A thread has used up its CPU time: the process terminates once its last
+ * thread is done
+ */
+static void finish_process(SimContext *ctx, Process *t, int clock) {
+    plugin_exit(ctx, t, clock);
+    Process *done = thread_exit(ctx, t, clock);
+    if (done != NULL) {
+        done->completion_clock = clock;
+        hook_fire(SCHED_HOOK_TERMINATE, done, clock);
+        ctx->terminated_count++;
+        ctx->steady_done |= steady_record(ctx, METRIC_TURNAROUND,
+                                          clock - done->arrival_clock);
+        
+        sim_log(ctx, "[Clock: %d] PID %d TERMINATED\n", clock, done->pid);
+        
+        if (memory_capacity > 0) {
+            mem_release(ctx, done, clock);
+        }
+    }
+}
+
+/**
+ * Finish the burst of a core's running process: I/O, termination or,
+ * in a closed system, the user's next think time
+ */
+static void core_finish_burst(SimContext *ctx, Core *core, int clock) {
+    Process *running_process = core->running_process;
+    if (running_process == NULL || clock < core->running_until) {
+        return;
+    }
+    
+    // Every core of a gang is released; the leader completes the burst
+    if (running_process->threads > 1 && running_process->gang_leader != (int)(core - ctx->cores)) {
+        core->running_process = NULL;
+        core_refresh(ctx, core);
+        smt_changed(ctx, core, clock);
+        return;
+    }
+    
+    if (noise_count > 0) {
+        noise_burst_done(ctx, core);
+    }
+    
+    // Process finished its interval burst
+    int burst_time = clock - (core->running_until - running_process->interval_time);
+    if (burst_time > running_process->remaining_time) {
+        burst_time = running_process->remaining_time;
+    }
+    
+    running_process->remaining_time -= burst_time;
+    hook_fire(SCHED_HOOK_BURST_END, running_process, clock);
+    group_charge(ctx, running_process, burst_time, clock);
+    if (running_process->resource >= 0) {
+        resource_burst_done(ctx, running_process, clock);
+    }
+    
+    if (running_process->remaining_time <= 0 && ctx->closed) {
+        // Job done: the same user thinks, then resubmits with this PCB
+        sim_log(ctx, "[Clock: %d] PID %d TERMINATED\n", clock, running_process->pid);
+        hook_fire(SCHED_HOOK_TERMINATE, running_process, clock);
+        ctx->steady_done |= steady_record(ctx, METRIC_TURNAROUND,
+                                          clock - running_process->arrival_clock);
+        recycle_closed_job(ctx, running_process, clock);
+    } else if (running_process->remaining_time <= 0) {
+        if (running_process->aio_depth == 0 || !aio_drain(ctx, running_process, clock)) {
+            finish_process(ctx, running_process, clock);
+        }
+    } else if (running_process->aio_depth > 0) {
+        // Asynchronous I/O: keep computing unless the ring is full or a wait is due
+        if (!aio_wait(ctx, running_process, clock, aio_issue(ctx, running_process, clock))) {
+            running_process->state = STATE_READY;
+            running_process->ready_since = clock;
+            make_ready(ctx, running_process);
+        } else {
+            plugin_block(ctx, running_process, clock);
+        }
+    } else {
+        // Process needs I/O
+        running_process->state = STATE_WAITING;
+        running_process->io_completion_time = clock + running_process->io_time;
+        plugin_block(ctx, running_process, clock);
+        hook_fire(SCHED_HOOK_IO_START, running_process, clock);
+        
+        sim_log(ctx, "[Clock: %d] PID %d blocked for I/O for %d ms\n",
+                clock, running_process->pid, running_process->io_time);
+        
+        enqueue(&ctx->waiting_queue, running_process);
+    }
+    
+    core->running_process = NULL;
+    core_refresh(ctx, core);
+    smt_changed(ctx, core, clock);
+}
+
+/**
+ * Dispatch the next process if this core is idle
+ * While a gang job holds a reservation, only bursts that cannot delay it
+ * may start (and none without backfilling).
+ */
+static void core_dispatch(SimContext *ctx, Core *core, int clock) {
+    if (core->running_process != NULL || core->offline || core_ready_count(core) == 0 ||
+        (ctx->gang_reserved && !ctx->gang_backfill)) {
+        return;
+    }
+    
+    Process *running_process = core_pick(ctx, core, clock);
+    if (running_process == NULL) {
+        return;
+    }
+    if (ctx->gang_reserved) {
+        gang_backfill_claim(ctx, burst_length(running_process), 1, clock);
+        ctx->backfilled_single++;
+    }
+    
+    // The ready wait lasts until the burst starts on the woken core
+    int wake = core_wake(ctx, core, clock);
+    int burst_time = begin_burst(ctx, running_process, clock + wake);
+    int wall = mem_scale(ctx, dvfs_scale(burst_time, core->level));
+    
+    core->burst_start = clock + wake;
+    core->running_until = clock + wake + wall;
+    core->burst_level = core->level;
+    core->busy_time += wall;
+    ctx->busy_time += wall;
+    ctx->level_busy[core->level] += wall;
+    
+    if (ctx->num_cores == 1) {
+        sim_log(ctx, "[Clock: %d] Scheduler dispatched PID %d (Pr: %d, Rm: %d) for %d ms burst\n",
+                clock, running_process->pid, sched_priority(running_process),
+                running_process->remaining_time, burst_time);
+    } else {
+        sim_log(ctx, "[Clock: %d] Scheduler dispatched PID %d (Pr: %d, Rm: %d) for %d ms burst on core %d\n",
+                clock, running_process->pid, sched_priority(running_process),
+                running_process->remaining_time, burst_time, (int)(core - ctx->cores));
+    }
+    
+    core->running_process = running_process;
+    core_refresh(ctx, core);
+    smt_begin(ctx, core, clock);
+}
+
+/**
+ * Advance the simulation by one clock tick
+ * 
+ * Implements Priority-SRTF non-preemptive scheduling:
+ * 1. Check for arriving processes
+ * 2. Update aging mechanism
+ * 3. Select next process from ready queue (already sorted by Priority-SRTF)
+ * 4. Run process for its interval_time (non-preemptive)
+ * 5. Handle I/O or termination
+ * 
+ * Returns 1 once the run is over.
+ */
+int scheduler_tick(SimContext *ctx) {
+    pthread_mutex_lock(&ctx->clock_mutex);
+    ctx->current_clock++;
+    int clock = ctx->current_clock;
+    pthread_mutex_unlock(&ctx->clock_mutex);
+    
+    pthread_mutex_lock(&ctx->queue_mutex);
+    
+    if (ctx->fragment_cores > 0) {
+        ctx->fragmented_time += (long)ctx->fragment_cores * (clock - ctx->fragment_since);
+        ctx->fragment_cores = 0;
+    }
+    
+    // Check for new arrivals
+    while (ctx->next_arrival < ctx->total_processes &&
+           ctx->processes[ctx->next_arrival].arrival_time <= clock) {
+        admit_process(ctx, &ctx->processes[ctx->next_arrival++], clock);
+    }
+    while (!is_empty(&ctx->inbox) && ctx->inbox.head->arrival_time <= clock) {
+        admit_process(ctx, dequeue(&ctx->inbox), clock);
+    }
+    
+    // Fire due timer events
+    while (timer_next(&ctx->timers) <= clock) {
+        Timer t = timer_pop(&ctx->timers);
+        handle_timer(ctx, &t, clock);
+    }
+    
+    // Update aging every 1ms for processes in ready queues
+    if (clock > ctx->last_aging_check) {
+        int elapsed = clock - ctx->last_aging_check;
+        if (ctx->plugin != NULL && ctx->plugin->on_tick != NULL) {
+            ctx->plugin_calls++;
+            ctx->plugin->on_tick(ctx->plugin_state, clock, elapsed);
+        }
+        int aged = 0;
+        for (int c = 0; ctx->plugin == NULL && c < ctx->num_cores; c++) {
+            Core *core = &ctx->cores[c];
+            if (ctx->policy != POLICY_SRTF) {
+                aged |= update_aging_heap(core->heap, core->heap_size, elapsed, clock);
+            } else {
+                aged |= update_aging(&core->ready_queue, elapsed, clock);
+            }
+        }
+        if (aged && ctx->pool_size > 0) {
+            resort_all_queues(ctx);  // Threads of an aged process may be queued elsewhere
+        } else if (ctx->policy == POLICY_SRTF) {
+            for (int c = 0; c < ctx->num_cores; c++) {
+                resort_ready_queue(&ctx->cores[c].ready_queue);
+            }
+        }
+        for (uint64_t mask = ctx->gang_classes; mask != 0; mask &= mask - 1) {
+            Queue *q = &ctx->gang_ready[__builtin_ctzll(mask) + 1];
+            update_aging(q, elapsed, clock);
+            resort_ready_queue(q);
+        }
+        ctx->last_aging_check = clock;
+    }
+    
+    for (int c = 0; c < ctx->num_cores; c++) {
+        core_finish_burst(ctx, &ctx->cores[c], clock);
+    }
+    if (ctx->gang_waiting > 0) {
+        gang_dispatch(ctx, clock);
+    }
+    for (int c = 0; c < ctx->num_cores; c++) {
+        core_dispatch(ctx, &ctx->cores[c], clock);
+    }
+    
+    // Idle cores while gang jobs wait are lost to fragmentation
+    if (ctx->gang_waiting > 0) {
+        int idle = 0;
+        for (int c = 0; c < ctx->num_cores; c++) {
+            idle += ctx->cores[c].running_process == NULL && !ctx->cores[c].offline;
+        }
+        ctx->fragment_cores = idle;
+        ctx->fragment_since = clock;
+    }
+    
+    // Virtual time has no I/O thread: complete I/O after this tick's events
+    if (!ctx->realtime) {
+        complete_io(ctx, clock);
+    }
+    while (!is_empty(&ctx->drained)) {
+        finish_process(ctx, dequeue(&ctx->drained), clock);
+    }
+    
+    if (ctx->checkpoint_interval > 0 && clock >= ctx->next_checkpoint) {
+        sim_checkpoint(ctx);
+    }
+    
+    // Check if all processes are terminated
+    int all_done = ctx->terminated_count == ctx->total_processes;
+    int out_of_time = ctx->end_clock > 0 && clock >= ctx->end_clock;
+    int idle = 1;
+    for (int c = 0; idle && c < ctx->num_cores; c++) {
+        idle = ctx->cores[c].running_process == NULL;
+    }
+    all_done = all_done && idle;
+    
+    // Gang jobs wider than the online cores cannot start once nothing else can
+    // happen; jobs that fit (e.g. back from I/O this tick) start next tick
+    uint64_t startable = gang_classes_upto(ctx->num_cores - ctx->offline_cores);
+    if (idle && !all_done && ctx->gang_waiting > 0 && ctx->ready_total == 0 &&
+        (ctx->gang_classes & startable) == 0 &&
+        is_empty(&ctx->waiting_queue) && ctx->timers.size == ctx->periodic_timers &&
+        ctx->next_arrival == ctx->total_processes) {
+        sim_log(ctx, "[Clock: %d] Stopping: %d gang job(s) need more cores than are online\n",
+                clock, ctx->gang_waiting);
+        all_done = 1;
+    }
+    
+    if (all_done || ctx->steady_done || ctx->converged ||
+        out_of_time) {
+        ctx->all_terminated = 1;
+        ctx->steady_stopped_early = ctx->steady_done &&
+                                    ctx->terminated_count < ctx->total_processes;
+        ctx->stop_clock = clock;
+        pthread_mutex_unlock(&ctx->queue_mutex);
+        return 1;
+    }
+    
+    if (!ctx->realtime) {
+        skip_idle_ticks(ctx, clock);
+    }
+    
+    pthread_mutex_unlock(&ctx->queue_mutex);
+    return 0;
+}
+
+/**
+ * Prepare a loaded context for its first tick. Returns -1 on failure.
+ */
+int scheduler_setup(SimContext *ctx) {
+    // Dispatch and noise draws come from their own sub-streams, so neither
+    // the policy nor --noise changes arrivals and think times
+    ctx->dispatch_rng = ctx->rng;
+    rng_long_jump(&ctx->dispatch_rng);
+    ctx->noise_rng = ctx->dispatch_rng;
+    rng_long_jump(&ctx->noise_rng);
+    if (ctx->plugin != NULL) {
+        if (resource_count > 0) {
+            fprintf(stderr, "Error: Policy plugins do not support res= resources\n");
+            return -1;
+        }
+        ctx->plugin_state = ctx->plugin->init(ctx->num_cores);
+        if (ctx->plugin_state == NULL) {
+            fprintf(stderr, "Error: Policy plugin %s failed to initialize\n", ctx->plugin->name);
+            return -1;
+        }
+    }
+    // Ready heaps need room for the worker threads as well
+    if (threads_setup(ctx) != 0) {
+        return -1;
+    }
+    dispatch_setup(ctx);
+    if (resource_count > 0) {
+        resources_setup(ctx);
+    }
+    core_events_setup(ctx);
+    smt_setup(ctx);
+    noise_setup(ctx);
+    if (freq_count > 0) {
+        dvfs_setup(ctx);
+    }
+    return 0;
+}
+
+/**
+ * Main Scheduler Function
+ * Ticks the clock until every process has terminated. Real-time runs
+ * sleep 1ms per tick; virtual-time runs advance as fast as possible.
+ */
+void run_scheduler(SimContext *ctx) {
+    if (scheduler_setup(ctx) != 0) {
+        return;
+    }
+    if (ctx->lock_memory) {
+        fault_prepare(ctx);
+    }
+    while (!scheduler_tick(ctx)) {
+        if (ctx->realtime) {
+            usleep(1000);  // Sleep for 1ms
+        }
+    }
+    if (ctx->lock_memory) {
+        fault_finish(ctx);
+    }
+}
+
+/**
+ * Run a loaded context to completion
+ * Real-time runs get their own I/O manager thread.
+ */
+int run_simulation(SimContext *ctx) {
+    if (!ctx->realtime) {
+        run_scheduler(ctx);
+        return 0;
+    }
+    
+    // Create I/O manager thread
+    pthread_t io_thread;
+    if (pthread_create(&io_thread, NULL, io_manager_thread, ctx) != 0) {
+        perror("Error creating I/O manager thread");
+        return -1;
+    }
+    
+    // Run scheduler in calling thread
+    run_scheduler(ctx);
+    
+    // Wait for I/O thread to finish
+    if (pthread_join(io_thread, NULL) != 0) {
+        perror("Error joining I/O manager thread");
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * RUN SUMMARY
+ * ============================================================================ */
+
+/**
+ * Derive summary metrics from the per-process records of a finished run
+ */
+void compute_summary(SimContext *ctx, RunSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    double *v = summary->values;
+    int *turnarounds = malloc(sizeof(int) * ctx->total_processes);
+    int completed = 0;
+    double wait_sum = 0.0, response_sum = 0.0, turnaround_sum = 0.0;
+    
+    for (int i = 0; i < ctx->total_processes; i++) {
+        Process *p = &ctx->processes[i];
+        if (p->completion_clock < 0) {
+            continue;
+        }
+        int turnaround = p->completion_clock - p->arrival_clock;
+        if (turnarounds != NULL) {
+            turnarounds[completed] = turnaround;
+        }
+        completed++;
+        wait_sum += p->total_wait;
+        response_sum += p->first_dispatch_clock - p->arrival_clock;
+        turnaround_sum += turnaround;
+    }
+    
+    v[SUMMARY_COMPLETED] = completed;
+    v[SUMMARY_MAKESPAN] = ctx->stop_clock;
+    if (ctx->stop_clock > 0) {
+        v[SUMMARY_THROUGHPUT] = 1000.0 * completed / ctx->stop_clock;
+        v[SUMMARY_UTILIZATION] = (double)ctx->busy_time / ((double)ctx->stop_clock * ctx->num_cores);
+    }
+    if (completed > 0) {
+        v[SUMMARY_MEAN_WAIT] = wait_sum / completed;
+        v[SUMMARY_MEAN_RESPONSE] = response_sum / completed;
+        v[SUMMARY_MEAN_TURNAROUND] = turnaround_sum / completed;
+        if (turnarounds != NULL) {
+            qsort(turnarounds, completed, sizeof(int), compare_int);
+            v[SUMMARY_P95_TURNAROUND] = turnarounds[(int)(0.95 * (completed - 1))];
+            v[SUMMARY_MAX_TURNAROUND] = turnarounds[completed - 1];
+        }
+    }
+    free(turnarounds);
+}
+
+/**
+ * Print the summary of a single run
+ */
+void print_summary(FILE *out, const RunSummary *summary) {
+    fprintf(out, "\n=== Run Summary ===\n");
+    for (int i = 0; i < NUM_SUMMARY_METRICS; i++) {
+        fprintf(out, "%-20s %14.3f\n", summary_metric_names[i], summary->values[i]);
+    }
+}
+
+/**
+ * Print time at each frequency, energy and the latency it bought
+ */
+void print_dvfs_report(SimContext *ctx) {
+    RunSummary summary;
+    compute_summary(ctx, &summary);
+    
+    double capacity = (double)ctx->stop_clock * ctx->num_cores;
+    double busy = 0.0, active_joules = 0.0;
+    printf("\n=== DVFS Report (%s) ===\n", governor_names[governor]);
+    printf("%10s %12s %10s\n", "MHz", "Busy (ms)", "Watts");
+    for (int l = 0; l < freq_count; l++) {
+        printf("%10d %12ld %10.2f\n", freq_levels[l], ctx->level_busy[l], level_watts(l));
+        busy += ctx->level_busy[l];
+        active_joules += ctx->level_busy[l] * level_watts(l) / 1000.0;
+    }
+    double idle_joules = (capacity - busy) * idle_watts / 1000.0;
+    double joules = active_joules + idle_joules;
+    
+    printf("Frequency changes: %ld\n", ctx->freq_changes);
+    printf("Energy: %.2f J (%.2f active, %.2f idle), mean power %.2f W\n",
+           joules, active_joules, idle_joules,
+           ctx->stop_clock > 0 ? 1000.0 * joules / ctx->stop_clock : 0.0);
+    if (summary.values[SUMMARY_COMPLETED] > 0) {
+        printf("Energy per completed process: %.3f J\n", joules / summary.values[SUMMARY_COMPLETED]);
+    }
+    printf("Makespan: %d ms, turnaround mean %.1f / p95 %.0f / max %.0f ms\n", ctx->stop_clock,
+           summary.values[SUMMARY_MEAN_TURNAROUND], summary.values[SUMMARY_P95_TURNAROUND],
+           summary.values[SUMMARY_MAX_TURNAROUND]);
+}
+
+/* ============================================================================
+ * THREAD POOL
+ * ============================================================================ */
+
+/**
+ * Number of online host CPUs (at least 1)
+ */
+int host_cpu_count() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/**
+ * Per-worker job queue of a work-stealing run
+ * Holds job indices in submission order (largest job first)
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int *jobs;
+    int head;                       // Next job to take
+    int tail;                       // One past the last job
+} JobQueue;
+
+/**
+ * Shared state of a parallel job run
+ */
+typedef struct {
+    void (*fn)(int job, void *arg);
+    void *arg;
+    JobQueue *queues;               // One queue per worker
+    int workers;
+    long steals;                    // Jobs taken from another worker (atomic)
+} ParallelRun;
+
+typedef struct {
+    ParallelRun *run;
+    int id;
+} ParallelWorker;
+
+/**
+ * Take the next job from a queue, or -1 if it is empty
+ */
+static int job_queue_take(JobQueue *q) {
+    int job = -1;
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail) {
+        job = q->jobs[q->head++];
+    }
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+static void* parallel_worker(void *arg) {
+    ParallelWorker *self = (ParallelWorker *)arg;
+    ParallelRun *run = self->run;
+    
+    while (1) {
+        int job = job_queue_take(&run->queues[self->id]);
+        
+        // Own queue drained: steal the largest unstarted job of another worker
+        for (int v = 1; job < 0 && v < run->workers; v++) {
+            job = job_queue_take(&run->queues[(self->id + v) % run->workers]);
+            if (job >= 0) {
+                __atomic_fetch_add(&run->steals, 1, __ATOMIC_RELAXED);
+            }
+        }
+        if (job < 0) {
+            break;  // Jobs are never added, so every queue is empty
+        }
+        run->fn(job, run->arg);
+    }
+    return NULL;
+}
+
+/**
+ * Run fn(0..jobs-1) on a work-stealing pool of worker threads
+ *
+ * Jobs should be numbered largest first. They are dealt round-robin to the
+ * workers' queues; an idle worker steals the next unstarted job of its
+ * neighbours, so stragglers never leave threads idle while work remains.
+ * The calling thread takes part, so threads == 1 runs inline.
+ * Returns the number of steals, or -1 on allocation failure.
+ */
+long run_parallel(int jobs, int threads, void (*fn)(int job, void *arg), void *arg) {
+    if (threads > jobs) {
+        threads = jobs;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    
+    ParallelRun run = { fn, arg, NULL, threads, 0 };
+    int *slots = malloc(sizeof(int) * (jobs > 0 ? jobs : 1));
+    run.queues = malloc(sizeof(JobQueue) * threads);
+    if (slots == NULL || run.queues == NULL) {
+        perror("Error allocating job queues");
+        free(slots);
+        free(run.queues);
+        return -1;
+    }
+    
+    // Deal jobs round-robin so every worker starts on a large one
+    int used = 0;
+    for (int w = 0; w < threads; w++) {
+        JobQueue *q = &run.queues[w];
+        pthread_mutex_init(&q->lock, NULL);
+        q->jobs = slots + used;
+        q->head = 0;
+        q->tail = 0;
+        for (int job = w; job < jobs; job += threads) {
+            q->jobs[q->tail++] = job;
+        }
+        used += q->tail;
+    }
+    
+    pthread_t workers[threads];
+    ParallelWorker args[threads];
+    int started = 0;
+    for (int w = 0; w < threads; w++) {
+        args[w].run = &run;
+        args[w].id = w;
+    }
+    for (int w = 1; w < threads; w++) {
+        if (pthread_create(&workers[started], NULL, parallel_worker, &args[w]) != 0) {
+            perror("Error creating worker thread");
+            break;  // Remaining queues are drained by stealing
+        }
+        started++;
+    }
+    
+    parallel_worker(&args[0]);
+    
+    for (int i = 0; i < started; i++) {
+        if (pthread_join(workers[i], NULL) != 0) {
+            perror("Error joining worker thread");
+        }
+    }
+    
+    for (int w = 0; w < threads; w++) {
+        pthread_mutex_destroy(&run.queues[w].lock);
+    }
+    free(run.queues);
+    free(slots);
+    return run.steals;
+}
+
+/* ============================================================================
+ * INDEPENDENT REPLICATIONS
+ * ============================================================================ */
+
+/**
+ * Replication batch: one generated workload per independent stream
+ */
+typedef struct {
+    const WorkloadSpec *spec;
+    Rng *streams;                   // Stream r is the seed jumped r times
+    RunSummary *results;
+    int *failed;
+} ReplicationSet;
+
+static void replication_job(int r, void *arg) {
+    ReplicationSet *set = (ReplicationSet *)arg;
+    SimContext ctx;
+    
+    sim_init(&ctx, 0, 1);
+    if (generate_workload(&ctx, set->spec, &set->streams[r]) != 0) {
+        set->failed[r] = 1;
+        sim_destroy(&ctx);
+        return;
+    }
+    ctx.rng = set->streams[r];          // Continue the stream for dispatch draws
+    run_scheduler(&ctx);
+    compute_summary(&ctx, &set->results[r]);
+    sim_destroy(&ctx);
+}
+
+/**
+ * Run R seeded replications of a generated workload in parallel and
+ * report the mean and 95% confidence interval of every summary metric
+ */
+int run_replications(const WorkloadSpec *spec, int replications, int threads,
+                     uint64_t seed) {
+    Rng *streams = malloc(sizeof(Rng) * replications);
+    RunSummary *results = malloc(sizeof(RunSummary) * replications);
+    int *failed = calloc(replications, sizeof(int));
+    if (streams == NULL || results == NULL || failed == NULL) {
+        perror("Error allocating replications");
+        free(streams);
+        free(results);
+        free(failed);
+        return -1;
+    }
+    
+    // Non-overlapping streams: each replication starts 2^128 draws later
+    rng_seed(&streams[0], seed);
+    for (int r = 1; r < replications; r++) {
+        streams[r] = streams[r - 1];
+        rng_jump(&streams[r]);
+    }
+    
+    ReplicationSet set = { spec, streams, results, failed };
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    run_parallel(replications, threads, replication_job, &set);
+    gettimeofday(&end, NULL);
+    
+    int ok = 0;
+    for (int r = 0; r < replications; r++) {
+        if (!failed[r]) {
+            results[ok++] = results[r];
+        }
+    }
+    
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    printf("=== Replications Report ===\n");
+    printf("Replications: %d (%d failed), seed %llu, %d threads, %.3f s wall\n",
+           replications, replications - ok, (unsigned long long)seed, threads, elapsed);
+    printf("%-20s %14s %14s %14s\n", "Metric", "Mean", "Std dev", "95% CI +/-");
+    
+    for (int i = 0; i < NUM_SUMMARY_METRICS; i++) {
+        double sum = 0.0, sum_sq = 0.0;
+        for (int r = 0; r < ok; r++) {
+            sum += results[r].values[i];
+        }
+        double mean = ok > 0 ? sum / ok : 0.0;
+        for (int r = 0; r < ok; r++) {
+            double d = results[r].values[i] - mean;
+            sum_sq += d * d;
+        }
+        double sd = ok > 1 ? sqrt(sum_sq / (ok - 1)) : 0.0;
+        double hw = ok > 1 ? t_quantile_975(ok - 1) * sd / sqrt(ok) : 0.0;
+        printf("%-20s %14.3f %14.3f %14.3f\n", summary_metric_names[i], mean, sd, hw);
+    }
+    
+    free(streams);
+    free(results);
+    free(failed);
+    return ok == replications ? 0 : -1;
+}
+
+/* ============================================================================
+ * BATCH RUNNER
+ * ============================================================================ */
+
+/**
+ * One workload file of a batch run
+ */
+typedef struct {
+    char path[PATH_MAX];
+    off_t size;                     // File size, used to order work largest first
+    RunSummary summary;
+    int processes;
+    int failed;
+    double seconds;                 // Wall time spent simulating this file
+} BatchItem;
+
+typedef struct {
+    BatchItem *items;
+    int count;
+    const char *out_dir;
+} BatchSet;
+
+static int compare_batch_size(const void *a, const void *b) {
+    const BatchItem *x = (const BatchItem *)a, *y = (const BatchItem *)b;
+    if (x->size != y->size) {
+        return x->size > y->size ? -1 : 1;
+    }
+    return strcmp(x->path, y->path);
+}
+
+/**
+ * Append one file to the batch if it is a regular file
+ */
+static int add_batch_item(BatchItem **items, int *count, int *capacity, const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return 0;
+    }
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 64;
+        BatchItem *grown = realloc(*items, sizeof(BatchItem) * new_capacity);
+        if (grown == NULL) {
+            perror("Error allocating batch list");
+            return -1;
+        }
+        *items = grown;
+        *capacity = new_capacity;
+    }
+    BatchItem *item = &(*items)[(*count)++];
+    memset(item, 0, sizeof(*item));
+    snprintf(item->path, sizeof(item->path), "%s", path);
+    item->size = st.st_size;
+    return 0;
+}
+
+/**
+ * Expand a directory or glob pattern into workload files, largest first
+ */
+int collect_batch_inputs(const char *pattern, BatchItem **items, int *count) {
+    int capacity = 0;
+    struct stat st;
+    *items = NULL;
+    *count = 0;
+    
+    if (stat(pattern, &st) == 0 && S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(pattern);
+        if (dir == NULL) {
+            perror("Error opening batch directory");
+            return -1;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.') {
+                continue;  // Skip hidden files, "." and ".."
+            }
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%s", pattern, entry->d_name);
+            if (add_batch_item(items, count, &capacity, path) != 0) {
+                closedir(dir);
+                return -1;
+            }
+        }
+        closedir(dir);
+    } else {
+        glob_t matches;
+        int rc = glob(pattern, 0, NULL, &matches);
+        if (rc != 0 && rc != GLOB_NOMATCH) {
+            fprintf(stderr, "Error: Cannot expand batch pattern '%s'\n", pattern);
+            return -1;
+        }
+        for (size_t i = 0; rc == 0 && i < matches.gl_pathc; i++) {
+            if (add_batch_item(items, count, &capacity, matches.gl_pathv[i]) != 0) {
+                globfree(&matches);
+                return -1;
+            }
+        }
+        if (rc == 0) {
+            globfree(&matches);
+        }
+    }
+    
+    if (*count == 0) {
+        fprintf(stderr, "Error: No workload files match '%s'\n", pattern);
+        return -1;
+    }
+    qsort(*items, *count, sizeof(BatchItem), compare_batch_size);
+    return 0;
+}
+
+static const char* batch_name(const BatchItem *item) {
+    const char *name = strrchr(item->path, '/');
+    return name != NULL ? name + 1 : item->path;
+}
+
+static int compare_batch_name(const void *a, const void *b) {
+    return strcmp(batch_name(*(const BatchItem * const *)a),
+                  batch_name(*(const BatchItem * const *)b));
+}
+
+/**
+ * Summaries are named after the file name alone, so two inputs with the
+ * same name in different directories would overwrite each other's
+ * Returns -1 after reporting the first clash.
+ */
+static int check_batch_names(const BatchItem *items, int count) {
+    const BatchItem **sorted = malloc(sizeof(BatchItem *) * count);
+    if (sorted == NULL) {
+        perror("Error allocating batch list");
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        sorted[i] = &items[i];
+    }
+    qsort(sorted, count, sizeof(BatchItem *), compare_batch_name);
+    int rc = 0;
+    for (int i = 1; i < count; i++) {
+        if (strcmp(batch_name(sorted[i - 1]), batch_name(sorted[i])) == 0) {
+            fprintf(stderr, "Error: Batch inputs %s and %s share the summary name %s.summary\n",
+                    sorted[i - 1]->path, sorted[i]->path, batch_name(sorted[i]));
+            rc = -1;
+            break;
+        }
+    }
+    free(sorted);
+    return rc;
+}
+
+static void batch_job(int i, void *arg) {
+    BatchSet *set = (BatchSet *)arg;
+    BatchItem *item = &set->items[i];
+    SimContext ctx;
+    struct timeval start, end;
+    
+    gettimeofday(&start, NULL);
+    sim_init(&ctx, 0, 1);
+    if (parse_input_file(&ctx, item->path) != 0) {
+        item->failed = 1;
+        sim_destroy(&ctx);
+        return;
+    }
+    run_scheduler(&ctx);
+    compute_summary(&ctx, &item->summary);
+    item->processes = ctx.total_processes;
+    sim_destroy(&ctx);
+    gettimeofday(&end, NULL);
+    item->seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    
+    // Per-file summary: <out_dir>/<file name>.summary
+    char out_path[PATH_MAX];
+    if (snprintf(out_path, sizeof(out_path), "%s/%s.summary",
+                 set->out_dir, batch_name(item)) >= (int)sizeof(out_path)) {
+        fprintf(stderr, "Error: Summary path too long for %s\n", item->path);
+        return;
+    }
+    
+    FILE *out = fopen(out_path, "w");
+    if (out == NULL) {
+        perror("Error writing batch summary");
+        return;
+    }
+    fprintf(out, "input                %s\n", item->path);
+    fprintf(out, "processes            %d\n", item->processes);
+    print_summary(out, &item->summary);
+    fclose(out);
+}
+
+/**
+ * Simulate every workload matched by a directory or glob in one process
+ * and print an aggregate table
+ */
+int run_batch(const char *pattern, const char *out_dir, int threads) {
+    BatchItem *items;
+    int count;
+    if (collect_batch_inputs(pattern, &items, &count) != 0) {
+        return -1;
+    }
+    if (check_batch_names(items, count) != 0) {
+        free(items);
+        return -1;
+    }
+    
+    if (mkdir(out_dir, 0755) != 0 && errno != EEXIST) {
+        perror("Error creating batch output directory");
+        free(items);
+        return -1;
+    }
+    
+    BatchSet set = { items, count, out_dir };
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    long steals = run_parallel(count, threads, batch_job, &set);
+    gettimeofday(&end, NULL);
+    double wall = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    
+    printf("=== Batch Report ===\n");
+    printf("%-32s %10s %8s %12s %12s %14s %12s %9s\n", "File", "Bytes", "Procs",
+           "Makespan", "Mean wait", "Mean turnar.", "P95 turnar.", "Sim (s)");
+    
+    int failed = 0;
+    long total_processes = 0;
+    double busy = 0.0, weighted_turnaround = 0.0, completed = 0.0;
+    for (int i = 0; i < count; i++) {
+        BatchItem *item = &items[i];
+        const char *name = batch_name(item);
+        if (item->failed) {
+            printf("%-32.32s %10lld %8s %12s\n", name, (long long)item->size, "-", "FAILED");
+            failed++;
+            continue;
+        }
+        const double *v = item->summary.values;
+        printf("%-32.32s %10lld %8d %12.0f %12.3f %14.3f %12.0f %9.3f\n",
+               name, (long long)item->size, item->processes, v[SUMMARY_MAKESPAN],
+               v[SUMMARY_MEAN_WAIT], v[SUMMARY_MEAN_TURNAROUND],
+               v[SUMMARY_P95_TURNAROUND], item->seconds);
+        total_processes += item->processes;
+        busy += item->seconds;
+        completed += v[SUMMARY_COMPLETED];
+        weighted_turnaround += v[SUMMARY_MEAN_TURNAROUND] * v[SUMMARY_COMPLETED];
+    }
+    
+    printf("\nFiles: %d (%d failed), processes: %ld, mean turnaround: %.3f ms\n",
+           count, failed, total_processes,
+           completed > 0 ? weighted_turnaround / completed : 0.0);
+    printf("Wall time: %.3f s, simulation time: %.3f s, %d threads, %ld steals, "
+           "parallel efficiency: %.1f%%\n", wall, busy, threads, steals,
+           wall > 0 ? 100.0 * busy / (wall * (threads < count ? threads : count)) : 0.0);
+    printf("Per-file summaries written to %s/\n", out_dir);
+    
+    free(items);
+    return failed == 0 ? 0 : -1;
+}
+
+/* ============================================================================
+ * ANALYTICAL ESTIMATOR
+ * ============================================================================ */
+
+/**
+ * Per-priority workload moments gathered in one streaming pass
+ * A "job" of the queueing model is one CPU burst.
+ */
+typedef struct {
+    long processes;
+    double cpu_sum;                 // Total CPU demand of the class (ms)
+    long bursts;
+    double burst_sum;               // Sum of burst lengths (ms)
+    double burst_sq_sum;            // Sum of squared burst lengths (ms^2)
+    long ios;
+    double io_sum;                  // Sum of I/O times (ms)
+    double io_sq_sum;               // Sum of squared I/O times (ms^2)
+} PriorityMoments;
+
+typedef struct {
+    PriorityMoments cls[NUM_PRIORITIES];
+    long processes;
+    int first_arrival;
+    int last_arrival;
+} WorkloadMoments;
+
+/**
+ * Prediction of the M/G/1 non-preemptive priority model
+ */
+typedef struct {
+    double lambda[NUM_PRIORITIES];  // Burst arrival rate per class (1/ms)
+    double rho[NUM_PRIORITIES];     // Offered utilization per class
+    double wait_us[NUM_PRIORITIES]; // Predicted mean ready-queue wait (us)
+    double utilization;             // Total offered utilization
+} PriorityEstimate;
+
+static int accumulate_moments(const Process *p, void *arg) {
+    WorkloadMoments *w = (WorkloadMoments *)arg;
+    PriorityMoments *m = &w->cls[priority_class(p->original_priority)];
+    int arrival = effective_arrival(p);
+    
+    if (w->processes == 0 || arrival < w->first_arrival) {
+        w->first_arrival = arrival;
+    }
+    if (w->processes == 0 || arrival > w->last_arrival) {
+        w->last_arrival = arrival;
+    }
+    w->processes++;
+    m->processes++;
+    m->cpu_sum += p->cpu_execution_time;
+    
+    if (p->cpu_execution_time <= 0 || p->interval_time <= 0) {
+        return 0;
+    }
+    
+    // Full bursts of interval_time plus a shorter final burst; one I/O between each
+    long full = p->cpu_execution_time / p->interval_time;
+    int last = p->cpu_execution_time % p->interval_time;
+    long bursts = full + (last > 0);
+    m->bursts += bursts;
+    m->burst_sum += p->cpu_execution_time;
+    m->burst_sq_sum += (double)full * p->interval_time * p->interval_time +
+                       (double)last * last;
+    m->ios += bursts - 1;
+    m->io_sum += (double)(bursts - 1) * p->io_time;
+    m->io_sq_sum += (double)(bursts - 1) * p->io_time * p->io_time;
+    return 0;
+}
+
+/**
+ * Observation window of the workload in ms
+ * n arrivals spanning s ms estimate a rate of (n-1)/s, so the window
+ * used for rates is s * n / (n-1).
+ */
+static double moments_window(const WorkloadMoments *w) {
+    double span = w->last_arrival - w->first_arrival;
+    if (w->processes < 2 || span <= 0) {
+        return 1.0;
+    }
+    return span * w->processes / (w->processes - 1);
+}
+
+/**
+ * Apply Cobham's formula for the M/G/1 non-preemptive priority queue:
+ *   W_k = W0 / ((1 - sigma_{k-1}) (1 - sigma_k)),  W0 = sum_i lambda_i E[S_i^2] / 2
+ * where sigma_k is the utilization of classes 0..k. Aging is ignored.
+ */
+void estimate_priority_waits(const WorkloadMoments *w, PriorityEstimate *est) {
+    double window = moments_window(w);
+    double w0 = 0.0;
+    
+    memset(est, 0, sizeof(*est));
+    for (int k = 0; k < NUM_PRIORITIES; k++) {
+        const PriorityMoments *m = &w->cls[k];
+        est->lambda[k] = m->bursts / window;
+        est->rho[k] = m->burst_sum / window;
+        w0 += m->burst_sq_sum / window / 2.0;
+        est->utilization += est->rho[k];
+    }
+    
+    double sigma = 0.0;
+    for (int k = 0; k < NUM_PRIORITIES; k++) {
+        double sigma_prev = sigma;
+        sigma += est->rho[k];
+        if (sigma < 1.0) {
+            est->wait_us[k] = 1000.0 * w0 / ((1.0 - sigma_prev) * (1.0 - sigma));
+        } else {
+            est->wait_us[k] = INFINITY;  // Class saturated: waits grow without bound
+        }
+    }
+}
+
+/**
+ * Print the workload characterization and predicted waits
+ */
+void print_estimate(const WorkloadMoments *w, const PriorityEstimate *est) {
+    double window = moments_window(w);
+    
+    printf("=== M/G/1 Priority Estimate ===\n");
+    printf("Processes: %ld, arrival window: %.0f ms, arrival rate: %.3f /s\n",
+           w->processes, window, 1000.0 * w->processes / window);
+    printf("%-3s %8s %10s %10s %12s %12s %10s %8s %16s\n", "Pr", "Procs", "CPU (ms)",
+           "Bursts/s", "E[S] (ms)", "E[S^2]", "E[IO] ms", "Rho", "Pred. wait (us)");
+    
+    for (int k = 0; k < NUM_PRIORITIES; k++) {
+        const PriorityMoments *m = &w->cls[k];
+        if (m->processes == 0) {
+            continue;
+        }
+        printf("%-3d %8ld %10.2f %10.3f %12.3f %12.2f %10.3f %8.4f %16.1f\n",
+               k, m->processes, m->cpu_sum / m->processes,
+               1000.0 * est->lambda[k],
+               m->bursts ? m->burst_sum / m->bursts : 0.0,
+               m->bursts ? m->burst_sq_sum / m->bursts : 0.0,
+               m->ios ? m->io_sum / m->ios : 0.0,
+               est->rho[k], est->wait_us[k]);
+    }
+    printf("Offered utilization: %.4f (%s)\n", est->utilization,
+           est->utilization < 1.0 ? "stable" : "overloaded");
+}
+
+/**
+ * Characterize the input in one streaming pass and predict per-priority
+ * waits; with validate, also simulate the same input in virtual time and
+ * report the estimation error
+ */
+int run_estimate(const char *filename, int validate) {
+    WorkloadMoments moments;
+    memset(&moments, 0, sizeof(moments));
+    if (for_each_input_record(filename, accumulate_moments, &moments) != 0) {
+        return -1;
+    }
+    if (moments.processes == 0) {
+        fprintf(stderr, "Error: No processes found in input file\n");
+        return -1;
+    }
+    
+    PriorityEstimate est;
+    estimate_priority_waits(&moments, &est);
+    print_estimate(&moments, &est);
+    if (!validate) {
+        return 0;
+    }
+    
+    SimContext ctx;
+    sim_init(&ctx, 0, 1);
+    if (parse_input_file(&ctx, filename) != 0) {
+        sim_destroy(&ctx);
+        return -1;
+    }
+    run_scheduler(&ctx);
+    
+    printf("\n=== Estimate vs Simulation ===\n");
+    printf("%-3s %12s %16s %16s %14s %10s\n", "Pr", "Dispatches",
+           "Pred. wait (us)", "Sim. wait (us)", "Error (us)", "Rel. err");
+    for (int k = 0; k < NUM_PRIORITIES; k++) {
+        if (ctx.dispatches_by_priority[k] == 0) {
+            continue;
+        }
+        double sim_us = 1000.0 * ctx.wait_by_priority[k] / ctx.dispatches_by_priority[k];
+        double err = est.wait_us[k] - sim_us;
+        printf("%-3d %12ld %16.1f %16.1f %14.1f", k, ctx.dispatches_by_priority[k],
+               est.wait_us[k], sim_us, err);
+        if (sim_us > 0.0 && isfinite(err)) {
+            printf(" %9.1f%%\n", 100.0 * err / sim_us);
+        } else {
+            printf(" %10s\n", "n/a");
+        }
+    }
+    double sim_util = ctx.stop_clock > 0
+                      ? (double)ctx.busy_time / ((double)ctx.stop_clock * ctx.num_cores) : 0.0;
+    printf("Utilization: predicted %.4f, simulated %.4f\n", est.utilization, sim_util);
+    
+    sim_destroy(&ctx);
+    return 0;
+}
+
+/* ============================================================================
+ * WORKLOAD CHARACTERIZATION
+ * ============================================================================ */
+
+#define SKETCH_ALPHA 0.01               // Relative error of sketch quantiles
+#define SKETCH_BUCKETS 1100             // Covers 1 .. INT_MAX at SKETCH_ALPHA
+#define RATE_WINDOWS 32                 // Arrival-rate windows kept at any time
+#define NUM_SKETCHES 3
+
+static const double sketch_quantiles[] = { 0.1, 0.5, 0.9, 0.99, 0.999 };
+#define NUM_SKETCH_QUANTILES (int)(sizeof(sketch_quantiles) / sizeof(sketch_quantiles[0]))
+
+/**
+ * Log-bucket quantile sketch: value v > 0 lands in bucket ceil(log_g(v)),
+ * g = (1 + a) / (1 - a), so every quantile is within a relative error of a
+ * Memory is fixed no matter how many values are added.
+ */
+typedef struct {
+    long count;
+    long zeros;                     // Values <= 0
+    int min;
+    int max;
+    double sum;
+    long buckets[SKETCH_BUCKETS];
+} Sketch;
+
+/**
+ * Arrivals per window; window i covers [i * width, (i + 1) * width) ms
+ * An arrival past the last window doubles the width and merges pairs.
+ */
+typedef struct {
+    long width;
+    long counts[RATE_WINDOWS];
+} RateSeries;
+
+typedef struct {
+    long processes;
+    long out_of_order;              // Records arriving before their predecessor
+    long zero_cpu;
+    long bad_priority;              // Outside 0..MAX_PRIORITY
+    int first_arrival;
+    int last_arrival;
+    int prev_arrival;
+    Sketch cpu;
+    Sketch interval;
+    Sketch io;
+    RateSeries rate;
+    long class_processes[NUM_PRIORITIES];
+    double class_cpu[NUM_PRIORITIES];   // CPU demand per priority (ms)
+    double io_sum;                      // Total I/O time of all processes (ms)
+    long *ends;                     // Min-heap of in-flight completion times
+    int ends_count;
+    int ends_capacity;
+    int max_concurrency;
+    int max_concurrency_at;
+} WorkloadProfile;
+
+static void sketch_add(Sketch *s, int v) {
+    if (s->count == 0 || v < s->min) {
+        s->min = v;
+    }
+    if (s->count == 0 || v > s->max) {
+        s->max = v;
+    }
+    s->count++;
+    s->sum += v;
+    if (v <= 0) {
+        s->zeros++;
+        return;
+    }
+    int b = (int)ceil(log((double)v) / log((1.0 + SKETCH_ALPHA) / (1.0 - SKETCH_ALPHA)));
+    s->buckets[b < SKETCH_BUCKETS ? b : SKETCH_BUCKETS - 1]++;
+}
+
+/**
+ * Value at quantile q: the midpoint of the bucket holding rank q * (count - 1),
+ * clamped to the exact minimum and maximum
+ */
+static double sketch_quantile(const Sketch *s, double q) {
+    double gamma = (1.0 + SKETCH_ALPHA) / (1.0 - SKETCH_ALPHA);
+    long rank = (long)(q * (s->count - 1));
+    if (rank < s->zeros) {
+        return s->min;
+    }
+    long seen = s->zeros;
+    for (int b = 0; b < SKETCH_BUCKETS; b++) {
+        seen += s->buckets[b];
+        if (seen > rank) {
+            double v = 2.0 * pow(gamma, b) / (gamma + 1.0);
+            return v < s->min ? s->min : (v > s->max ? s->max : v);
+        }
+    }
+    return s->max;
+}
+
+static void rate_add(RateSeries *r, int t) {
+    while (t >= r->width * RATE_WINDOWS) {
+        for (int i = 0; i < RATE_WINDOWS / 2; i++) {
+            r->counts[i] = r->counts[2 * i] + r->counts[2 * i + 1];
+        }
+        memset(&r->counts[RATE_WINDOWS / 2], 0, sizeof(long) * (RATE_WINDOWS / 2));
+        r->width *= 2;
+    }
+    r->counts[t / r->width]++;
+}
+
+static void ends_push(WorkloadProfile *w, long end) {
+    int i = w->ends_count++;
+    while (i > 0 && w->ends[(i - 1) / 2] > end) {
+        w->ends[i] = w->ends[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    w->ends[i] = end;
+}
+
+static void ends_pop(WorkloadProfile *w) {
+    long last = w->ends[--w->ends_count];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= w->ends_count) {
+            break;
+        }
+        if (c + 1 < w->ends_count && w->ends[c + 1] < w->ends[c]) {
+            c++;
+        }
+        if (w->ends[c] >= last) {
+            break;
+        }
+        w->ends[i] = w->ends[c];
+        i = c;
+    }
+    w->ends[i] = last;
+}
+
+/**
+ * Track processes in flight, each taking its unloaded lifetime (all bursts
+ * plus all I/O, no waiting); the heap holds only those still in flight
+ */
+static int track_concurrency(WorkloadProfile *w, int arrival, long lifetime) {
+    while (w->ends_count > 0 && w->ends[0] <= arrival) {
+        ends_pop(w);
+    }
+    if (w->ends_count == w->ends_capacity) {
+        int new_capacity = w->ends_capacity ? w->ends_capacity * 2 : 1024;
+        long *grown = realloc(w->ends, sizeof(long) * new_capacity);
+        if (grown == NULL) {
+            perror("Error allocating concurrency heap");
+            return -1;
+        }
+        w->ends = grown;
+        w->ends_capacity = new_capacity;
+    }
+    ends_push(w, arrival + (lifetime > 0 ? lifetime : 1));
+    if (w->ends_count > w->max_concurrency) {
+        w->max_concurrency = w->ends_count;
+        w->max_concurrency_at = arrival;
+    }
+    return 0;
+}
+
+static int profile_record(const Process *p, void *arg) {
+    WorkloadProfile *w = (WorkloadProfile *)arg;
+    int arrival = effective_arrival(p);
+    
+    if (w->processes == 0 || arrival < w->first_arrival) {
+        w->first_arrival = arrival;
+    }
+    if (w->processes == 0 || arrival > w->last_arrival) {
+        w->last_arrival = arrival;
+    }
+    if (w->processes > 0 && arrival < w->prev_arrival) {
+        w->out_of_order++;
+    }
+    w->prev_arrival = arrival;
+    w->processes++;
+    
+    if (p->cpu_execution_time <= 0) {
+        w->zero_cpu++;
+    }
+    if (p->original_priority < 0 || p->original_priority > MAX_PRIORITY) {
+        w->bad_priority++;
+    }
+    sketch_add(&w->cpu, p->cpu_execution_time);
+    sketch_add(&w->interval, p->interval_time);
+    sketch_add(&w->io, p->io_time);
+    rate_add(&w->rate, arrival);
+    
+    int k = priority_class(p->original_priority);
+    w->class_processes[k]++;
+    w->class_cpu[k] += p->cpu_execution_time;
+    
+    // One I/O between consecutive bursts, as in the simulation
+    long ios = 0;
+    if (p->cpu_execution_time > 0 && p->interval_time > 0) {
+        ios = (p->cpu_execution_time + p->interval_time - 1) / p->interval_time - 1;
+    }
+    w->io_sum += (double)ios * p->io_time;
+    return track_concurrency(w, arrival, p->cpu_execution_time + ios * p->io_time);
+}
+
+/**
+ * Print the workload profile; parse_seconds is the wall time of the pass
+ */
+void print_profile(const char *filename, const WorkloadProfile *w, double parse_seconds) {
+    double span = w->last_arrival - w->first_arrival;
+    double window = span > 0 && w->processes > 1 ? span * w->processes / (w->processes - 1) : 1.0;
+    
+    printf("=== Workload Characterization ===\n");
+    printf("File: %s, processes: %ld, pass: %.3f s (%.0f records/s)\n", filename, w->processes,
+           parse_seconds, parse_seconds > 0 ? w->processes / parse_seconds : 0.0);
+    printf("Arrivals: %d to %d ms, mean rate %.3f /s\n", w->first_arrival, w->last_arrival,
+           1000.0 * w->processes / window);
+    
+    // Windows up to the one holding the last arrival; peak against mean shows bursts
+    int used = (int)(w->last_arrival / w->rate.width) + 1;
+    long peak = 0;
+    printf("\nArrival rate over %d windows of %ld ms:\n", used, w->rate.width);
+    printf("%12s %10s %12s\n", "Start (ms)", "Arrivals", "Rate (/s)");
+    for (int i = 0; i < used; i++) {
+        if (w->rate.counts[i] > peak) {
+            peak = w->rate.counts[i];
+        }
+        printf("%12ld %10ld %12.3f\n", i * w->rate.width, w->rate.counts[i],
+               1000.0 * w->rate.counts[i] / w->rate.width);
+    }
+    printf("Peak window rate: %.3f /s (%.2fx the mean)\n", 1000.0 * peak / w->rate.width,
+           (double)peak * window / w->rate.width / w->processes);
+    
+    const Sketch *sketches[NUM_SKETCHES] = { &w->cpu, &w->interval, &w->io };
+    const char *names[NUM_SKETCHES] = { "cpu_execution_time", "interval_time", "io_time" };
+    printf("\nDistributions (ms, quantiles within %.0f%%):\n", 100.0 * SKETCH_ALPHA);
+    printf("%-20s %8s", "Field", "Min");
+    for (int q = 0; q < NUM_SKETCH_QUANTILES; q++) {
+        char label[16];
+        snprintf(label, sizeof(label), "P%g", 100.0 * sketch_quantiles[q]);
+        printf(" %10s", label);
+    }
+    printf(" %10s %10s\n", "Max", "Mean");
+    for (int i = 0; i < NUM_SKETCHES; i++) {
+        const Sketch *s = sketches[i];
+        printf("%-20s %8d", names[i], s->min);
+        for (int q = 0; q < NUM_SKETCH_QUANTILES; q++) {
+            printf(" %10.1f", sketch_quantile(s, sketch_quantiles[q]));
+        }
+        printf(" %10d %10.2f\n", s->max, s->sum / s->count);
+    }
+    
+    double total = 0.0;
+    printf("\nOffered utilization per priority (%d core%s):\n", core_count,
+           core_count == 1 ? "" : "s");
+    printf("%-3s %10s %8s %14s %10s\n", "Pr", "Procs", "Share", "CPU (ms)", "Util");
+    for (int k = 0; k < NUM_PRIORITIES; k++) {
+        if (w->class_processes[k] == 0) {
+            continue;
+        }
+        double util = w->class_cpu[k] / window / core_count;
+        total += util;
+        printf("%-3d %10ld %7.1f%% %14.0f %10.4f\n", k, w->class_processes[k],
+               100.0 * w->class_processes[k] / w->processes, w->class_cpu[k], util);
+    }
+    printf("Offered utilization: %.4f (%s), I/O demand: %.1f ms per ms\n", total,
+           total < 1.0 ? "stable" : "overloaded", w->io_sum / window);
+    
+    printf("Max concurrency (unloaded lifetimes): %d at %d ms%s\n", w->max_concurrency,
+           w->max_concurrency_at, w->out_of_order > 0 ? " (input not sorted: approximate)" : "");
+    
+    // Problems worth fixing before a long simulation
+    if (w->out_of_order > 0) {
+        printf("Warning: %ld records arrive before the record above them\n", w->out_of_order);
+    }
+    if (w->zero_cpu > 0) {
+        printf("Warning: %ld processes need no CPU time\n", w->zero_cpu);
+    }
+    if (w->bad_priority > 0) {
+        printf("Warning: %ld priorities outside 0..%d (clamped in statistics)\n",
+               w->bad_priority, MAX_PRIORITY);
+    }
+    if (total >= 1.0) {
+        printf("Warning: offered utilization %.2f; queues grow for the whole run\n", total);
+    }
+}
+
+/**
+ * Characterize the input in one streaming pass without loading it
+ * Memory is fixed except for the concurrency heap, which holds only the
+ * processes in flight at one time.
+ */
+int run_characterize(const char *filename) {
+    WorkloadProfile *w = calloc(1, sizeof(WorkloadProfile));
+    if (w == NULL) {
+        perror("Error allocating workload profile");
+        return -1;
+    }
+    w->rate.width = 1;
+    
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    int rc = for_each_input_record(filename, profile_record, w);
+    gettimeofday(&end, NULL);
+    
+    if (rc == 0 && w->processes == 0) {
+        fprintf(stderr, "Error: No processes found in input file\n");
+        rc = -1;
+    }
+    if (rc == 0) {
+        print_profile(filename, w, (end.tv_sec - start.tv_sec) +
+                                   (end.tv_usec - start.tv_usec) / 1e6);
+    }
+    free(w->ends);
+    free(w);
+    return rc;
+}
+
+/* ============================================================================
+ * INCREMENTAL RE-SIMULATION
+ * ============================================================================ */
+
+#define CHECKPOINT_MAGIC "PSCKPT01"
+
+static int write_checkpoint(FILE *f, const Checkpoint *cp, int n) {
+    int header[8] = { cp->clock, cp->next_arrival, cp->terminated_count, cp->running,
+                      cp->running_until, cp->last_aging_check,
+                      cp->ready_count, cp->waiting_count };
+    return fwrite(header, sizeof(header), 1, f) == 1 &&
+           fwrite(&cp->busy_time, sizeof(cp->busy_time), 1, f) == 1 &&
+           fwrite(cp->ready_order, sizeof(int), cp->ready_count, f) == (size_t)cp->ready_count &&
+           fwrite(cp->waiting_order, sizeof(int), cp->waiting_count, f) == (size_t)cp->waiting_count &&
+           fwrite(cp->processes, sizeof(Process), n, f) == (size_t)n ? 0 : -1;
+}
+
+static int read_checkpoint(FILE *f, Checkpoint *cp, int n) {
+    int header[8];
+    memset(cp, 0, sizeof(*cp));
+    if (fread(header, sizeof(header), 1, f) != 1 ||
+        fread(&cp->busy_time, sizeof(cp->busy_time), 1, f) != 1 ||
+        header[6] < 0 || header[6] > n || header[7] < 0 || header[7] > n) {
+        return -1;
+    }
+    cp->clock = header[0];
+    cp->next_arrival = header[1];
+    cp->terminated_count = header[2];
+    cp->running = header[3];
+    cp->running_until = header[4];
+    cp->last_aging_check = header[5];
+    cp->ready_count = header[6];
+    cp->waiting_count = header[7];
+    
+    cp->ready_order = malloc(sizeof(int) * (cp->ready_count + 1));
+    cp->waiting_order = malloc(sizeof(int) * (cp->waiting_count + 1));
+    cp->processes = malloc(sizeof(Process) * n);
+    if (cp->ready_order == NULL || cp->waiting_order == NULL || cp->processes == NULL ||
+        fread(cp->ready_order, sizeof(int), cp->ready_count, f) != (size_t)cp->ready_count ||
+        fread(cp->waiting_order, sizeof(int), cp->waiting_count, f) != (size_t)cp->waiting_count ||
+        fread(cp->processes, sizeof(Process), n, f) != (size_t)n) {
+        checkpoint_free(cp);
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        cp->processes[i].next = NULL;
+    }
+    return 0;
+}
+
+/**
+ * Write the baseline workload and its checkpoints to disk
+ * The format is a raw dump meant for the host that wrote it.
+ */
+int save_checkpoints(const char *path, const Process *initial, const CheckpointLog *log) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror("Error opening checkpoint file");
+        return -1;
+    }
+    int n = log->total_processes;
+    int header[4] = { (int)sizeof(Process), n, log->interval, log->count };
+    int ok = fwrite(CHECKPOINT_MAGIC, 8, 1, f) == 1 &&
+             fwrite(header, sizeof(header), 1, f) == 1 &&
+             fwrite(initial, sizeof(Process), n, f) == (size_t)n;
+    for (int i = 0; ok && i < log->count; i++) {
+        ok = write_checkpoint(f, &log->items[i], n) == 0;
+    }
+    ok = ok && write_checkpoint(f, &log->final, n) == 0;
+    if (fclose(f) != 0 || !ok) {
+        perror("Error writing checkpoint file");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Load a checkpoint file written by save_checkpoints()
+ * Returns 1 if the file is not a checkpoint file, 0 on success, -1 on error.
+ */
+int load_checkpoints(const char *path, Process **initial, CheckpointLog *log) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror("Error opening baseline");
+        return -1;
+    }
+    char magic[8];
+    if (fread(magic, 8, 1, f) != 1 || memcmp(magic, CHECKPOINT_MAGIC, 8) != 0) {
+        fclose(f);
+        return 1;
+    }
+    
+    int header[4];
+    memset(log, 0, sizeof(*log));
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != (int)sizeof(Process) ||
+        header[1] <= 0 || header[2] <= 0 || header[3] < 0) {
+        fprintf(stderr, "Error: Incompatible checkpoint file '%s'\n", path);
+        fclose(f);
+        return -1;
+    }
+    int n = header[1];
+    log->total_processes = n;
+    log->interval = header[2];
+    log->capacity = header[3] > 0 ? header[3] : 1;
+    log->items = malloc(sizeof(Checkpoint) * log->capacity);
+    *initial = malloc(sizeof(Process) * n);
+    
+    int ok = log->items != NULL && *initial != NULL &&
+             fread(*initial, sizeof(Process), n, f) == (size_t)n;
+    for (int i = 0; ok && i < header[3]; i++) {
+        ok = read_checkpoint(f, &log->items[i], n) == 0;
+        log->count += ok;
+    }
+    ok = ok && read_checkpoint(f, &log->final, n) == 0;
+    fclose(f);
+    
+    if (!ok) {
+        fprintf(stderr, "Error: Truncated checkpoint file '%s'\n", path);
+        checkpoint_log_free(log);
+        free(*initial);
+        *initial = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Checkpoints do not record resource holders and waiters, worker threads or
+ * outstanding asynchronous I/Os
+ */
+static int reject_unsupported(const SimContext *ctx) {
+    if (resource_count > 0) {
+        fprintf(stderr, "Error: Checkpoints do not support res= attributes\n");
+        return 1;
+    }
+    for (int i = 0; i < ctx->total_processes; i++) {
+        if (ctx->processes[i].workers > 1) {
+            fprintf(stderr, "Error: Checkpoints do not support workers= attributes\n");
+            return 1;
+        }
+        if (ctx->processes[i].aio_depth > 0) {
+            fprintf(stderr, "Error: Checkpoints do not support aio= attributes\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Simulate a workload in virtual time, checkpointing every interval ms
+ * initial receives a copy of the workload before the run.
+ */
+int record_baseline(const char *filename, int interval, CheckpointLog *log,
+                    Process **initial) {
+    SimContext ctx;
+    sim_init(&ctx, 0, 1);
+    memset(log, 0, sizeof(*log));
+    if (parse_input_file(&ctx, filename) != 0 || reject_unsupported(&ctx)) {
+        sim_destroy(&ctx);
+        return -1;
+    }
+    
+    *initial = malloc(sizeof(Process) * ctx.total_processes);
+    if (*initial == NULL) {
+        perror("Error allocating baseline");
+        sim_destroy(&ctx);
+        return -1;
+    }
+    memcpy(*initial, ctx.processes, sizeof(Process) * ctx.total_processes);
+    
+    log->interval = interval;
+    log->total_processes = ctx.total_processes;
+    ctx.checkpoint_interval = interval;
+    ctx.next_checkpoint = interval;
+    ctx.checkpoints = log;
+    run_scheduler(&ctx);
+    
+    int rc = checkpoint_capture(&ctx, &log->final);
+    sim_destroy(&ctx);
+    return rc;
+}
+
+/**
+ * Load the edited context with the baseline state of a checkpoint
+ * Unchanged processes take their checkpointed PCB; edited and new ones
+ * have not arrived yet and keep their initial state.
+ */
+void restore_checkpoint(SimContext *ctx, const Checkpoint *cp, const Process *initial,
+                        const PidIndex *edit_pids, int base_n) {
+    int *base_to_edit = malloc(sizeof(int) * base_n);
+    for (int j = 0; j < base_n; j++) {
+        int e = pid_lookup(edit_pids, ctx->total_processes, initial[j].pid);
+        if (base_to_edit != NULL) {
+            base_to_edit[j] = e;
+        }
+        if (e >= 0 && same_input(&ctx->processes[e], &initial[j])) {
+            ctx->processes[e] = cp->processes[j];
+        }
+    }
+    
+    Core *core = &ctx->cores[0];
+    ctx->current_clock = cp->clock;
+    core->running_until = cp->running_until;
+    ctx->last_aging_check = cp->last_aging_check;
+    ctx->busy_time = cp->busy_time;
+    core->busy_time = cp->busy_time;
+    core->running_process = NULL;
+    ctx->next_arrival = 0;
+    ctx->terminated_count = 0;
+    for (int i = 0; i < ctx->total_processes; i++) {
+        ctx->next_arrival += ctx->processes[i].has_arrived;
+        ctx->terminated_count += ctx->processes[i].state == STATE_TERMINATED;
+    }
+    
+    if (base_to_edit != NULL) {
+        // Queue members and the running process arrived before the edit
+        for (int i = 0; i < cp->ready_count; i++) {
+            enqueue(&core->ready_queue, &ctx->processes[base_to_edit[cp->ready_order[i]]]);
+        }
+        for (int i = 0; i < cp->waiting_count; i++) {
+            enqueue(&ctx->waiting_queue, &ctx->processes[base_to_edit[cp->waiting_order[i]]]);
+        }
+        if (cp->running >= 0) {
+            core->running_process = &ctx->processes[base_to_edit[cp->running]];
+        }
+    }
+    free(base_to_edit);
+}
+
+/**
+ * Complete a converged run with the baseline's remaining history
+ * Live processes finish exactly as in the baseline; only their
+ * accumulated wait is shifted by what the edit changed before convergence.
+ */
+void merge_baseline_tail(SimContext *ctx, const Checkpoint *matched, const Checkpoint *final,
+                         const PidIndex *base_pids, int base_n) {
+    for (int i = 0; i < ctx->total_processes; i++) {
+        Process *e = &ctx->processes[i];
+        if (e->state == STATE_TERMINATED) {
+            continue;
+        }
+        int j = pid_lookup(base_pids, base_n, e->pid);
+        const Process *b = &matched->processes[j];
+        const Process *f = &final->processes[j];
+        
+        int wait_shift = e->total_wait - b->total_wait;
+        if (e->state == STATE_READY) {
+            wait_shift += b->ready_since - e->ready_since;
+        }
+        if (e->first_dispatch_clock < 0) {
+            e->first_dispatch_clock = f->first_dispatch_clock;
+        }
+        e->arrival_clock = f->arrival_clock;
+        e->total_wait = f->total_wait + wait_shift;
+        e->completion_clock = f->completion_clock;
+        e->remaining_time = f->remaining_time;
+        e->state = f->state;
+    }
+    ctx->busy_time += final->busy_time - matched->busy_time;
+    ctx->terminated_count = ctx->total_processes;
+    ctx->stop_clock = final->clock;
+}
+
+/**
+ * Re-simulate an edited workload against a recorded baseline
+ *
+ * Resumes from the last checkpoint before the first arrival touched by the
+ * edit and stops as soon as the state matches a baseline checkpoint again.
+ * The baseline is a checkpoint file or a workload simulated in memory.
+ */
+int run_incremental(const char *edited_file, const char *baseline, int interval) {
+    CheckpointLog log;
+    Process *initial = NULL;
+    int rc = load_checkpoints(baseline, &initial, &log);
+    if (rc < 0) {
+        return -1;
+    }
+    const char *source = "checkpoints from file";
+    if (rc == 1) {
+        source = "in-memory checkpoints";
+        if (record_baseline(baseline, interval, &log, &initial) != 0) {
+            checkpoint_log_free(&log);
+            free(initial);
+            return -1;
+        }
+    }
+    int base_n = log.total_processes;
+    
+    SimContext ctx;
+    sim_init(&ctx, 0, 1);
+    PidIndex *base_pids = build_pid_index(initial, base_n);
+    PidIndex *edit_pids = NULL;
+    if (base_pids == NULL || parse_input_file(&ctx, edited_file) != 0 || reject_unsupported(&ctx) ||
+        (edit_pids = build_pid_index(ctx.processes, ctx.total_processes)) == NULL) {
+        free(base_pids);
+        free(initial);
+        checkpoint_log_free(&log);
+        sim_destroy(&ctx);
+        return -1;
+    }
+    
+    // Diff the workloads: the first affected event is the earliest arrival,
+    // old or new, of any changed, added or removed process
+    int changed = 0, added = 0, removed = 0;
+    int first_affected = INT_MAX;
+    for (int i = 0; i < ctx.total_processes; i++) {
+        const Process *e = &ctx.processes[i];
+        int j = pid_lookup(base_pids, base_n, e->pid);
+        if (j < 0) {
+            added++;
+        } else if (!same_input(e, &initial[j])) {
+            changed++;
+            if (effective_arrival(&initial[j]) < first_affected) {
+                first_affected = effective_arrival(&initial[j]);
+            }
+        } else {
+            continue;
+        }
+        if (effective_arrival(e) < first_affected) {
+            first_affected = effective_arrival(e);
+        }
+    }
+    for (int j = 0; j < base_n; j++) {
+        if (pid_lookup(edit_pids, ctx.total_processes, initial[j].pid) < 0) {
+            removed++;
+            if (effective_arrival(&initial[j]) < first_affected) {
+                first_affected = effective_arrival(&initial[j]);
+            }
+        }
+    }
+    
+    // Resume from the last checkpoint taken before the affected arrival
+    const Checkpoint *resume = NULL;
+    for (int k = 0; k < log.count && log.items[k].clock < first_affected; k++) {
+        resume = &log.items[k];
+    }
+    if (first_affected == INT_MAX) {
+        resume = &log.final;  // No edits: the baseline result stands
+    }
+    if (resume != NULL) {
+        restore_checkpoint(&ctx, resume, initial, edit_pids, base_n);
+    }
+    int resume_clock = ctx.current_clock;
+    
+    ConvergenceTarget target = { &log, base_pids, edit_pids, 0, NULL };
+    ctx.checkpoint_interval = log.interval;
+    ctx.next_checkpoint = (resume_clock / log.interval + 1) * log.interval;
+    ctx.converge = &target;
+    if (first_affected == INT_MAX) {
+        ctx.stop_clock = log.final.clock;
+    } else {
+        run_scheduler(&ctx);
+    }
+    
+    int simulated = ctx.stop_clock - resume_clock;
+    if (ctx.converged) {
+        merge_baseline_tail(&ctx, target.matched, &log.final, base_pids, base_n);
+    }
+    
+    printf("=== Incremental Re-simulation ===\n");
+    printf("Baseline: %d processes, %d %s every %d ms, final clock %d\n",
+           base_n, log.count, source, log.interval, log.final.clock);
+    printf("Edits: %d changed, %d added, %d removed", changed, added, removed);
+    if (first_affected != INT_MAX) {
+        printf("; first affected arrival at %d ms\n", first_affected);
+    } else {
+        printf("; baseline result reused\n");
+    }
+    printf("Resumed from clock %d", resume_clock);
+    if (first_affected == INT_MAX) {
+        printf(", nothing to re-simulate\n");
+    } else if (ctx.converged) {
+        printf(", converged with baseline at clock %d\n", target.matched->clock);
+    } else {
+        printf(", no convergence before the end of the run\n");
+    }
+    printf("Simulated %d of %d ms (%.1f%% of a full run)\n", simulated, ctx.stop_clock,
+           ctx.stop_clock > 0 ? 100.0 * simulated / ctx.stop_clock : 0.0);
+    
+    RunSummary summary;
+    compute_summary(&ctx, &summary);
+    print_summary(stdout, &summary);
+    
+    free(base_pids);
+    free(edit_pids);
+    free(initial);
+    checkpoint_log_free(&log);
+    sim_destroy(&ctx);
+    return 0;
+}
+
+/**
+ * Simulate a workload and write its checkpoints for later --resume runs
+ */
+int run_save_checkpoints(const char *filename, const char *path, int interval) {
+    CheckpointLog log;
+    Process *initial = NULL;
+    int rc = record_baseline(filename, interval, &log, &initial);
+    if (rc == 0) {
+        rc = save_checkpoints(path, initial, &log);
+    }
+    if (rc == 0) {
+        printf("Saved %d checkpoints (every %d ms, final clock %d) to %s\n",
+               log.count, interval, log.final.clock, path);
+    }
+    free(initial);
+    checkpoint_log_free(&log);
+    return rc;
+}
+
+/* ============================================================================
+ * CLOSED SYSTEM
+ * ============================================================================ */
+
+/**
+ * Result of one closed-population run
+ */
+typedef struct {
+    int users;
+    long jobs;
+    double throughput;              // Jobs per second
+    double mean_response;           // ms
+    double sd_response;             // ms
+    int max_response;               // ms
+    double utilization;
+} ClosedResult;
+
+typedef struct {
+    const Process *templates;       // Job shapes, assigned to users round-robin
+    int template_count;
+    const int *populations;
+    double think_mean;
+    int duration;
+    Rng *streams;                   // One think-time stream per population
+    ClosedResult *results;
+    int *failed;
+} ClosedSweep;
+
+/**
+ * Simulate N users for the configured duration
+ * Memory is N PCBs and at most N pending arrivals, whatever the duration.
+ */
+static void closed_job(int r, void *arg) {
+    ClosedSweep *sweep = (ClosedSweep *)arg;
+    int users = sweep->populations[r];
+    SimContext ctx;
+    
+    sim_init(&ctx, 0, 1);
+    ctx.processes = malloc(sizeof(Process) * users);
+    if (ctx.processes == NULL) {
+        perror("Error allocating users");
+        sweep->failed[r] = 1;
+        sim_destroy(&ctx);
+        return;
+    }
+    ctx.total_processes = users;
+    ctx.next_arrival = users;       // All arrivals come from the timer heap
+    ctx.closed = 1;
+    ctx.think_mean = sweep->think_mean;
+    ctx.rng = sweep->streams[r];
+    ctx.end_clock = sweep->duration;
+    
+    for (int u = 0; u < users; u++) {
+        const Process *t = &sweep->templates[u % sweep->template_count];
+        int think = think_time(&ctx.rng, sweep->think_mean);
+        init_process(&ctx.processes[u], u + 1, think, t->cpu_execution_time,
+                     t->interval_time, t->io_time, t->original_priority);
+        ctx.processes[u].mem = t->mem;
+        timer_push(&ctx.timers, think, TIMER_ARRIVAL, u);
+    }
+    
+    run_scheduler(&ctx);
+    
+    ClosedResult *res = &sweep->results[r];
+    res->users = users;
+    res->jobs = ctx.jobs_completed;
+    res->throughput = 1000.0 * ctx.jobs_completed / ctx.stop_clock;
+    res->utilization = (double)ctx.busy_time / ((double)ctx.stop_clock * ctx.num_cores);
+    res->max_response = ctx.response_max;
+    if (ctx.jobs_completed > 0) {
+        double mean = ctx.response_sum / ctx.jobs_completed;
+        double var = ctx.response_sq_sum / ctx.jobs_completed - mean * mean;
+        res->mean_response = mean;
+        res->sd_response = var > 0.0 ? sqrt(var) : 0.0;
+    }
+    sim_destroy(&ctx);
+}
+
+/**
+ * Parse a comma-separated list of populations ("1,2,4,8")
+ * Returns the number of entries, or -1 on a malformed list.
+ */
+int parse_populations(const char *list, int **out) {
+    int count = 1;
+    for (const char *c = list; *c; c++) {
+        count += *c == ',';
+    }
+    *out = malloc(sizeof(int) * count);
+    if (*out == NULL) {
+        return -1;
+    }
+    
+    const char *c = list;
+    for (int i = 0; i < count; i++) {
+        char *end;
+        long n = strtol(c, &end, 10);
+        if (end == c || n < 1 || n > INT_MAX || (*end != ',' && *end != '\0')) {
+            free(*out);
+            return -1;
+        }
+        (*out)[i] = (int)n;
+        c = end + 1;
+    }
+    return count;
+}
+
+/**
+ * Sweep the closed population sizes in parallel and report throughput
+ * and response time versus N
+ */
+int run_closed_sweep(const Process *templates, int template_count, const int *populations,
+                     int runs, double think_mean, int duration, int threads,
+                     uint64_t seed) {
+    ClosedSweep sweep = { templates, template_count, populations, think_mean, duration,
+                          malloc(sizeof(Rng) * runs), malloc(sizeof(ClosedResult) * runs),
+                          calloc(runs, sizeof(int)) };
+    if (sweep.streams == NULL || sweep.results == NULL || sweep.failed == NULL) {
+        perror("Error allocating closed sweep");
+        free(sweep.streams);
+        free(sweep.results);
+        free(sweep.failed);
+        return -1;
+    }
+    memset(sweep.results, 0, sizeof(ClosedResult) * runs);
+    
+    rng_seed(&sweep.streams[0], seed);
+    for (int r = 1; r < runs; r++) {
+        sweep.streams[r] = sweep.streams[r - 1];
+        rng_jump(&sweep.streams[r]);
+    }
+    
+    run_parallel(runs, threads, closed_job, &sweep);
+    
+    printf("=== Closed-System Report ===\n");
+    printf("Think time: %.1f ms (exponential), duration: %d ms, %d job templates\n",
+           think_mean, duration, template_count);
+    printf("%8s %10s %12s %14s %12s %12s %8s %12s\n", "N", "Jobs", "X (jobs/s)",
+           "Mean resp (ms)", "Sd (ms)", "Max (ms)", "Util", "X*(R+Z)");
+    
+    int failed = 0;
+    for (int r = 0; r < runs; r++) {
+        const ClosedResult *res = &sweep.results[r];
+        if (sweep.failed[r]) {
+            printf("%8d %10s\n", populations[r], "FAILED");
+            failed++;
+            continue;
+        }
+        // Little's law: N = X (R + Z) when the run is long enough
+        double little = res->throughput / 1000.0 * (res->mean_response + think_mean);
+        printf("%8d %10ld %12.3f %14.3f %12.3f %12d %8.4f %12.2f\n", res->users, res->jobs,
+               res->throughput, res->mean_response, res->sd_response, res->max_response,
+               res->utilization, little);
+    }
+    
+    free(sweep.streams);
+    free(sweep.results);
+    free(sweep.failed);
+    return failed == 0 ? 0 : -1;
+}
+
+/* ============================================================================
+ * DISPATCH POLICY COMPARISON
+ * ============================================================================ */
+
+#define NUM_TAIL_QUANTILES 4
+
+static const double tail_quantiles[NUM_TAIL_QUANTILES] = { 0.50, 0.95, 0.99, 0.999 };
+
+/**
+ * Turnaround distribution of one policy's run
+ */
+typedef struct {
+    RunSummary summary;
+    double tail[NUM_TAIL_QUANTILES];    // Turnaround quantiles (ms)
+    double core_util_min;               // Least loaded core
+    double core_util_max;               // Most loaded core
+} DispatchResult;
+
+typedef struct {
+    const Process *processes;       // Workload, sorted by arrival
+    int count;
+    int policies[NUM_DISPATCH_POLICIES];
+    uint64_t seed;
+    DispatchResult *results;
+    int *failed;
+} DispatchSweep;
+
+/**
+ * Turnaround quantiles of the terminated processes
+ */
+static void turnaround_tail(SimContext *ctx, double *tail) {
+    int *turnarounds = malloc(sizeof(int) * (ctx->total_processes > 0 ? ctx->total_processes : 1));
+    int n = 0;
+    if (turnarounds == NULL) {
+        return;
+    }
+    for (int i = 0; i < ctx->total_processes; i++) {
+        const Process *p = &ctx->processes[i];
+        if (p->completion_clock >= 0) {
+            turnarounds[n++] = p->completion_clock - p->arrival_clock;
+        }
+    }
+    if (n > 0) {
+        qsort(turnarounds, n, sizeof(int), compare_int);
+        for (int q = 0; q < NUM_TAIL_QUANTILES; q++) {
+            tail[q] = turnarounds[(int)(tail_quantiles[q] * (n - 1))];
+        }
+    }
+    free(turnarounds);
+}
+
+/**
+ * Simulate the shared workload under one dispatch policy
+ */
+static void dispatch_job(int i, void *arg) {
+    DispatchSweep *sweep = (DispatchSweep *)arg;
+    DispatchResult *res = &sweep->results[i];
+    SimContext ctx;
+    
+    sim_init(&ctx, 0, 1);
+    ctx.dispatch = sweep->policies[i];
+    rng_seed(&ctx.rng, sweep->seed);     // Same draws for every policy
+    ctx.processes = malloc(sizeof(Process) * sweep->count);
+    if (ctx.processes == NULL) {
+        perror("Error allocating dispatch run");
+        sweep->failed[i] = 1;
+        sim_destroy(&ctx);
+        return;
+    }
+    memcpy(ctx.processes, sweep->processes, sizeof(Process) * sweep->count);
+    ctx.total_processes = sweep->count;
+    
+    run_scheduler(&ctx);
+    
+    compute_summary(&ctx, &res->summary);
+    turnaround_tail(&ctx, res->tail);
+    res->core_util_min = 1.0;
+    for (int c = 0; c < ctx.num_cores; c++) {
+        double util = (double)ctx.cores[c].busy_time / ctx.stop_clock;
+        res->core_util_min = util < res->core_util_min ? util : res->core_util_min;
+        res->core_util_max = util > res->core_util_max ? util : res->core_util_max;
+    }
+    sim_destroy(&ctx);
+}
+
+/**
+ * Run the same workload under each selected dispatch policy in parallel
+ * and compare tail latency
+ */
+int run_dispatch_comparison(const Process *processes, int count, unsigned policy_mask,
+                            int threads, uint64_t seed) {
+    DispatchSweep sweep = { processes, count, { 0 }, seed, NULL, NULL };
+    int runs = 0;
+    for (int i = 0; i < NUM_DISPATCH_POLICIES; i++) {
+        if (policy_mask & (1u << i)) {
+            sweep.policies[runs++] = i;
+        }
+    }
+    sweep.results = calloc(runs, sizeof(DispatchResult));
+    sweep.failed = calloc(runs, sizeof(int));
+    if (sweep.results == NULL || sweep.failed == NULL) {
+        perror("Error allocating dispatch comparison");
+        free(sweep.results);
+        free(sweep.failed);
+        return -1;
+    }
+    
+    run_parallel(runs, threads, dispatch_job, &sweep);
+    
+    printf("=== Dispatch Policy Report ===\n");
+    printf("Cores: %d, processes: %d, power-of-d samples: %d\n", core_count, count,
+           dispatch_choices);
+    printf("%-6s %8s %8s %8s %10s %10s %10s %10s %10s %10s %10s\n", "Policy", "Util",
+           "Min core", "Max core", "Mean wait", "Mean TA", "p50 TA", "p95 TA", "p99 TA",
+           "p99.9 TA", "Max TA");
+    
+    int failed = 0;
+    for (int i = 0; i < runs; i++) {
+        const DispatchResult *res = &sweep.results[i];
+        const double *v = res->summary.values;
+        if (sweep.failed[i]) {
+            printf("%-6s %8s\n", dispatch_policy_names[sweep.policies[i]], "FAILED");
+            failed++;
+            continue;
+        }
+        printf("%-6s %8.4f %8.4f %8.4f %10.1f %10.1f %10.0f %10.0f %10.0f %10.0f %10.0f\n",
+               dispatch_policy_names[sweep.policies[i]], v[SUMMARY_UTILIZATION],
+               res->core_util_min, res->core_util_max, v[SUMMARY_MEAN_WAIT],
+               v[SUMMARY_MEAN_TURNAROUND], res->tail[0], res->tail[1], res->tail[2],
+               res->tail[3], v[SUMMARY_MAX_TURNAROUND]);
+    }
+    
+    free(sweep.results);
+    free(sweep.failed);
+    return failed == 0 ? 0 : -1;
+}
+
+/* ============================================================================
+ * CLUSTER SIMULATION
+ * ============================================================================ */
+
+/**
+ * A cluster of scheduler nodes fed by one global dispatcher
+ * Every node is a complete single-machine engine. Each window the dispatcher
+ * routes the window's arrivals into node inboxes, then the nodes advance to
+ * the window's end in parallel, so routing sees node state at most one
+ * window old.
+ */
+typedef struct Cluster {
+    SimContext *nodes;
+    int count;
+    long *work;                     // CPU time routed to each node (ms)
+    int rr_next;
+    Rng rng;                        // Dispatcher's draws (random, pod)
+    int window_end;                 // Clock every node advances to this window
+    int finished;
+    int threads;
+    pthread_mutex_t gate;           // Held until the barriers are sized
+    pthread_barrier_t start;        // Window routed: nodes may run
+    pthread_barrier_t done;         // Every node reached window_end
+} Cluster;
+
+typedef struct {
+    Cluster *cluster;
+    int id;
+} ClusterWorker;
+
+/**
+ * Processes routed to a node that have not finished yet
+ */
+static int node_backlog(const SimContext *node) {
+    return node->total_processes - node->terminated_count;
+}
+
+/**
+ * CPU time routed to a node that it has not spent yet (noise is not work)
+ */
+static long node_work_left(const Cluster *cl, int n) {
+    return cl->work[n] - (cl->nodes[n].busy_time - cl->nodes[n].noise_busy);
+}
+
+static int place_jsq(Cluster *cl, const Process *p) {
+    (void)p;
+    int best = 0;
+    for (int n = 1; n < cl->count; n++) {
+        if (node_backlog(&cl->nodes[n]) < node_backlog(&cl->nodes[best])) {
+            best = n;
+        }
+    }
+    return best;
+}
+
+static int place_lwl(Cluster *cl, const Process *p) {
+    (void)p;
+    int best = 0;
+    for (int n = 1; n < cl->count; n++) {
+        if (node_work_left(cl, n) < node_work_left(cl, best)) {
+            best = n;
+        }
+    }
+    return best;
+}
+
+static int place_pod(Cluster *cl, const Process *p) {
+    (void)p;
+    int best = (int)(rng_next(&cl->rng) % cl->count);
+    for (int i = 1; i < dispatch_choices; i++) {
+        int other = (int)(rng_next(&cl->rng) % cl->count);
+        if (node_backlog(&cl->nodes[other]) < node_backlog(&cl->nodes[best])) {
+            best = other;
+        }
+    }
+    return best;
+}
+
+static int place_rr(Cluster *cl, const Process *p) {
+    (void)p;
+    int n = cl->rr_next;
+    cl->rr_next = (n + 1) % cl->count;
+    return n;
+}
+
+static int place_random(Cluster *cl, const Process *p) {
+    (void)p;
+    return (int)(rng_next(&cl->rng) % cl->count);
+}
+
+/**
+ * Placement policies, selected with --placement. A policy sees every
+ * node's state as of the start of the current window plus what it has
+ * routed since.
+ */
+typedef struct {
+    const char *name;
+    int (*place)(Cluster *cl, const Process *p);
+} Placement;
+
+#define NUM_PLACEMENTS 5
+
+static const Placement placements[NUM_PLACEMENTS] = {
+    { "jsq", place_jsq },
+    { "lwl", place_lwl },
+    { "pod", place_pod },
+    { "rr", place_rr },
+    { "random", place_random },
+};
+
+/**
+ * Tick one node up to the end of the current window
+ */
+static void node_advance(SimContext *node, int until) {
+    node->end_clock = until;
+    while (node->current_clock < until) {
+        if (scheduler_tick(node)) {
+            break;      // Drained its inbox early; the next window resumes it
+        }
+    }
+}
+
+/**
+ * Advance this worker's share of the nodes, one window at a time
+ */
+static void cluster_window_share(Cluster *cl, int id) {
+    for (int n = id; n < cl->count; n += cl->threads) {
+        node_advance(&cl->nodes[n], cl->window_end);
+    }
+}
+
+static void *cluster_worker(void *arg) {
+    ClusterWorker *w = (ClusterWorker *)arg;
+    Cluster *cl = w->cluster;
+    pthread_mutex_lock(&cl->gate);
+    pthread_mutex_unlock(&cl->gate);
+    for (;;) {
+        pthread_barrier_wait(&cl->start);
+        if (cl->finished) {
+            break;
+        }
+        cluster_window_share(cl, w->id);
+        pthread_barrier_wait(&cl->done);
+    }
+    return NULL;
+}
+
+/**
+ * Print cluster-wide utilization and latency
+ */
+static void print_cluster_report(Cluster *cl, Process *processes, int count, int windows,
+                                 double wall, int show_summary) {
+    SimContext view;
+    memset(&view, 0, sizeof(view));
+    view.processes = processes;
+    view.total_processes = count;
+    view.num_cores = cl->count * core_count;
+    for (int i = 0; i < count; i++) {
+        if (processes[i].completion_clock > view.stop_clock) {
+            view.stop_clock = processes[i].completion_clock;
+        }
+    }
+    double util_min = 1.0, util_max = 0.0;
+    int routed_min = INT_MAX, routed_max = 0;
+    for (int n = 0; n < cl->count; n++) {
+        const SimContext *node = &cl->nodes[n];
+        double util = view.stop_clock > 0
+                      ? (double)node->busy_time / ((double)view.stop_clock * core_count) : 0.0;
+        util_min = util < util_min ? util : util_min;
+        util_max = util > util_max ? util : util_max;
+        routed_min = node->total_processes < routed_min ? node->total_processes : routed_min;
+        routed_max = node->total_processes > routed_max ? node->total_processes : routed_max;
+        view.busy_time += node->busy_time;
+    }
+    
+    RunSummary summary;
+    double tail[NUM_TAIL_QUANTILES] = { 0 };
+    compute_summary(&view, &summary);
+    turnaround_tail(&view, tail);
+    const double *v = summary.values;
+    
+    printf("=== Cluster Report ===\n");
+    printf("Nodes: %d x %d core(s), placement %s, sync window %d ms, node threads %d\n",
+           cl->count, core_count, placements[cluster_placement].name, cluster_window,
+           cl->threads);
+    printf("Processes: %d, completed %.0f, per node %d..%d\n", count, v[SUMMARY_COMPLETED],
+           routed_min, routed_max);
+    printf("Utilization: cluster %.4f, node min %.4f, max %.4f\n", v[SUMMARY_UTILIZATION],
+           util_min, util_max);
+    printf("Latency (ms): mean wait %.1f, mean response %.1f, mean turnaround %.1f\n",
+           v[SUMMARY_MEAN_WAIT], v[SUMMARY_MEAN_RESPONSE], v[SUMMARY_MEAN_TURNAROUND]);
+    printf("Turnaround (ms): p50 %.0f, p95 %.0f, p99 %.0f, p99.9 %.0f, max %.0f\n",
+           tail[0], tail[1], tail[2], tail[3], v[SUMMARY_MAX_TURNAROUND]);
+    printf("Makespan: %d ms in %d windows, %.3f s wall (%.0f node-windows/s)\n",
+           view.stop_clock, windows, wall, wall > 0 ? (double)windows * cl->count / wall : 0.0);
+    if (show_summary) {
+        print_summary(stdout, &summary);
+    }
+}
+
+/**
+ * Simulate the workload on cluster_nodes nodes of core_count cores each
+ * Nodes run on a fixed set of threads and meet at a barrier after every
+ * sync window. Returns -1 on failure.
+ */
+int run_cluster(Process *processes, int count, int threads, uint64_t seed, int show_summary) {
+    for (int i = 0; i < count; i++) {
+        const Process *p = &processes[i];
+        if (p->threads > 1 || p->workers > 1 || p->resource >= 0) {
+            fprintf(stderr, "Error: --nodes does not support threads=, workers= or res= "
+                            "(PID %d)\n", p->pid);
+            return -1;
+        }
+    }
+    
+    Cluster cl;
+    memset(&cl, 0, sizeof(cl));
+    cl.count = cluster_nodes;
+    cl.threads = threads < cl.count ? threads : cl.count;
+    cl.nodes = calloc(cl.count, sizeof(SimContext));
+    cl.work = calloc(cl.count, sizeof(long));
+    if (cl.nodes == NULL || cl.work == NULL) {
+        perror("Error allocating cluster");
+        free(cl.nodes);
+        free(cl.work);
+        return -1;
+    }
+    
+    // Every node draws from its own stream; the dispatcher takes the next one
+    rng_seed(&cl.rng, seed);
+    int rc = 0;
+    for (int n = 0; n < cl.count; n++) {
+        sim_init(&cl.nodes[n], 0, 1);
+        cl.nodes[n].rng = cl.rng;
+        rng_jump(&cl.rng);
+        if (rc == 0 && scheduler_setup(&cl.nodes[n]) != 0) {
+            rc = -1;
+        }
+    }
+    
+    // Workers wait at the gate until the barriers know how many started
+    pthread_t workers[cl.threads];
+    ClusterWorker args[cl.threads];
+    int started = 0;
+    pthread_mutex_init(&cl.gate, NULL);
+    pthread_mutex_lock(&cl.gate);
+    for (int w = 1; rc == 0 && w < cl.threads; w++) {
+        args[w].cluster = &cl;
+        args[w].id = w;
+        if (pthread_create(&workers[started], NULL, cluster_worker, &args[w]) != 0) {
+            perror("Error creating node thread");
+            break;      // The threads that did start share the nodes
+        }
+        started++;
+    }
+    cl.threads = started + 1;
+    cl.finished = rc != 0;
+    pthread_barrier_init(&cl.start, NULL, cl.threads);
+    pthread_barrier_init(&cl.done, NULL, cl.threads);
+    pthread_mutex_unlock(&cl.gate);
+    
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    int next = 0;
+    int windows = 0;
+    while (!cl.finished) {
+        cl.window_end += cluster_window;
+        while (next < count && processes[next].arrival_time <= cl.window_end) {
+            Process *p = &processes[next++];
+            int n = placements[cluster_placement].place(&cl, p);
+            // Nodes have no processes array: their arrivals come only from the inbox
+            enqueue(&cl.nodes[n].inbox, p);
+            cl.nodes[n].total_processes++;
+            cl.nodes[n].next_arrival++;
+            cl.work[n] += p->cpu_execution_time;
+        }
+        
+        pthread_barrier_wait(&cl.start);
+        cluster_window_share(&cl, 0);
+        pthread_barrier_wait(&cl.done);
+        windows++;
+        
+        int backlog = count - next;
+        for (int n = 0; backlog == 0 && n < cl.count; n++) {
+            backlog = node_backlog(&cl.nodes[n]);
+        }
+        cl.finished = backlog == 0;
+    }
+    pthread_barrier_wait(&cl.start);        // Release the workers to exit
+    gettimeofday(&end, NULL);
+    for (int i = 0; i < started; i++) {
+        if (pthread_join(workers[i], NULL) != 0) {
+            perror("Error joining node thread");
+        }
+    }
+    pthread_barrier_destroy(&cl.start);
+    pthread_barrier_destroy(&cl.done);
+    pthread_mutex_destroy(&cl.gate);
+    
+    if (rc == 0) {
+        double wall = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+        print_cluster_report(&cl, processes, count, windows, wall, show_summary);
+    }
+    for (int n = 0; n < cl.count; n++) {
+        sim_destroy(&cl.nodes[n]);
+    }
+    free(cl.nodes);
+    free(cl.work);
+    return rc;
+}
+
+/* ============================================================================
+ * MULTIQUEUE
+ * ============================================================================ */
+
+#define MQ_HEAPS_PER_THREAD 2       // c: heaps per thread sharing the queue
+#define MQ_PREFILL 65536            // Ready-set size the benchmark runs at
+#define MQ_KEY_SPACE (NUM_PRIORITIES << 10)
+
+/**
+ * One heap of a MultiQueue, padded to its own cache line
+ * top caches the smallest key (LONG_MAX if empty) so deleters can compare
+ * heads without taking the lock.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    long *keys;                     // Binary min-heap
+    int size;
+    int cap;
+    long top;                       // Read and written atomically
+} __attribute__((aligned(64))) MQHeap;
+
+/**
+ * Relaxed concurrent priority queue: insert into a random heap, delete
+ * from the better of two random heads. A single heap is an exact queue
+ * behind one mutex.
+ */
+typedef struct {
+    MQHeap *heaps;
+    int count;
+} MultiQueue;
+
+/**
+ * Priority-SRTF order as one key: priority first, then remaining time
+ */
+static inline long mq_key(int priority, int remaining) {
+    return ((long)priority << 10) | (remaining < 1023 ? remaining : 1023);
+}
+
+int mq_init(MultiQueue *mq, int count) {
+    void *mem;
+    if (posix_memalign(&mem, 64, sizeof(MQHeap) * count) != 0) {
+        return -1;
+    }
+    mq->heaps = mem;
+    mq->count = count;
+    for (int i = 0; i < count; i++) {
+        MQHeap *h = &mq->heaps[i];
+        pthread_mutex_init(&h->lock, NULL);
+        h->keys = NULL;
+        h->size = 0;
+        h->cap = 0;
+        h->top = LONG_MAX;
+    }
+    return 0;
+}
+
+void mq_free(MultiQueue *mq) {
+    for (int i = 0; i < mq->count; i++) {
+        pthread_mutex_destroy(&mq->heaps[i].lock);
+        free(mq->heaps[i].keys);
+    }
+    free(mq->heaps);
+    mq->heaps = NULL;
+}
+
+/**
+ * Lock a heap: the single-heap queue blocks, a MultiQueue only tries and
+ * moves on to another heap if it is busy
+ */
+static inline int mq_lock(MultiQueue *mq, MQHeap *h) {
+    return mq->count == 1 ? pthread_mutex_lock(&h->lock) : pthread_mutex_trylock(&h->lock);
+}
+
+/**
+ * Push under the heap's lock; returns -1 if the heap cannot grow
+ */
+static int mq_heap_push(MQHeap *h, long key) {
+    if (h->size == h->cap) {
+        int cap = h->cap > 0 ? 2 * h->cap : 64;
+        long *keys = realloc(h->keys, sizeof(long) * cap);
+        if (keys == NULL) {
+            return -1;
+        }
+        h->keys = keys;
+        h->cap = cap;
+    }
+    int i = h->size++;
+    while (i > 0 && key < h->keys[(i - 1) / 2]) {
+        h->keys[i] = h->keys[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h->keys[i] = key;
+    __atomic_store_n(&h->top, h->keys[0], __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * Pop the smallest key of a non-empty heap under its lock
+ */
+static long mq_heap_pop(MQHeap *h) {
+    long top = h->keys[0];
+    long last = h->keys[--h->size];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= h->size) {
+            break;
+        }
+        if (c + 1 < h->size && h->keys[c + 1] < h->keys[c]) {
+            c++;
+        }
+        if (last <= h->keys[c]) {
+            break;
+        }
+        h->keys[i] = h->keys[c];
+        i = c;
+    }
+    if (h->size > 0) {
+        h->keys[i] = last;
+    }
+    __atomic_store_n(&h->top, h->size > 0 ? h->keys[0] : LONG_MAX, __ATOMIC_RELEASE);
+    return top;
+}
+
+/**
+ * Insert a key into a random heap. Returns -1 if out of memory.
+ */
+int mq_insert(MultiQueue *mq, Rng *rng, long key) {
+    for (;;) {
+        MQHeap *h = &mq->heaps[rng_next(rng) % mq->count];
+        if (mq_lock(mq, h) == 0) {
+            int rc = mq_heap_push(h, key);
+            pthread_mutex_unlock(&h->lock);
+            return rc;
+        }
+    }
+}
+
+/**
+ * Remove the smaller head of two random heaps into *key
+ * Returns 0 once every heap is seen empty.
+ */
+int mq_delete_min(MultiQueue *mq, Rng *rng, long *key) {
+    for (int attempt = 1; ; attempt++) {
+        MQHeap *a = &mq->heaps[rng_next(rng) % mq->count];
+        MQHeap *b = &mq->heaps[rng_next(rng) % mq->count];
+        long ta = __atomic_load_n(&a->top, __ATOMIC_ACQUIRE);
+        long tb = __atomic_load_n(&b->top, __ATOMIC_ACQUIRE);
+        MQHeap *h = tb < ta ? b : a;
+        
+        if ((tb < ta ? tb : ta) == LONG_MAX) {
+            if (attempt % mq->count != 0) {
+                continue;
+            }
+            int i = 0;
+            while (i < mq->count && __atomic_load_n(&mq->heaps[i].top, __ATOMIC_ACQUIRE) == LONG_MAX) {
+                i++;
+            }
+            if (i == mq->count) {
+                return 0;
+            }
+            continue;
+        }
+        if (mq_lock(mq, h) != 0) {
+            continue;
+        }
+        if (h->size == 0) {
+            pthread_mutex_unlock(&h->lock);     // Emptied since we looked
+            continue;
+        }
+        *key = mq_heap_pop(h);
+        pthread_mutex_unlock(&h->lock);
+        return 1;
+    }
+}
+
+/**
+ * Ready-set key a benchmark thread inserts: uniform priority and burst
+ */
+static inline long mq_random_key(Rng *rng) {
+    return mq_key((int)(rng_next(rng) % NUM_PRIORITIES), (int)(rng_next(rng) % 1024));
+}
+
+typedef struct {
+    MultiQueue *mq;
+    Rng *streams;                   // One per thread
+    long ops;                       // Delete-min/insert pairs per thread
+    int failed;
+} MQBench;
+
+/**
+ * One benchmark thread: repeatedly take the best ready process and make
+ * another one ready
+ */
+static void mq_bench_job(int t, void *arg) {
+    MQBench *bench = (MQBench *)arg;
+    Rng *rng = &bench->streams[t];
+    long key;
+    for (long i = 0; i < bench->ops; i++) {
+        mq_delete_min(bench->mq, rng, &key);
+        if (mq_insert(bench->mq, rng, mq_random_key(rng)) != 0) {
+            bench->failed = 1;
+            return;
+        }
+    }
+}
+
+/**
+ * Split the delete-min/insert pairs over the threads sharing one queue
+ * Returns million operations per second, or -1 on failure.
+ */
+static double mq_throughput(int heaps, int threads, long pairs, uint64_t seed) {
+    MultiQueue mq;
+    Rng streams[threads];
+    if (mq_init(&mq, heaps) != 0) {
+        return -1.0;
+    }
+    rng_seed(&streams[0], seed);
+    for (int i = 0; i < MQ_PREFILL; i++) {
+        mq_insert(&mq, &streams[0], mq_random_key(&streams[0]));
+    }
+    for (int t = 1; t < threads; t++) {
+        streams[t] = streams[t - 1];
+        rng_jump(&streams[t]);
+    }
+    
+    MQBench bench = { &mq, streams, pairs / threads, 0 };
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    run_parallel(threads, threads, mq_bench_job, &bench);
+    gettimeofday(&end, NULL);
+    double wall = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    
+    mq_free(&mq);
+    if (bench.failed) {
+        return -1.0;
+    }
+    return wall > 0 ? 2.0 * bench.ops * threads / wall / 1e6 : 0.0;
+}
+
+/**
+ * Rank error of each delete-min: how many queued keys were strictly
+ * smaller than the one returned. Replayed on one thread with a Fenwick
+ * tree over the key space so every delete is measured exactly.
+ */
+static int mq_rank_error(int heaps, long pairs, uint64_t seed, double *mean, int *p99, int *max) {
+    MultiQueue mq;
+    int *fenwick = calloc(MQ_KEY_SPACE + 1, sizeof(int));
+    int *ranks = malloc(sizeof(int) * (pairs > 0 ? pairs : 1));
+    if (fenwick == NULL || ranks == NULL || mq_init(&mq, heaps) != 0) {
+        free(fenwick);
+        free(ranks);
+        return -1;
+    }
     
-    while (!is_empty(&ready_queue)) {
-        processes[count++] = dequeue(&ready_queue);
+    Rng rng;
+    rng_seed(&rng, seed);
+    long sum = 0;
+    for (long i = 0; i < MQ_PREFILL + pairs; i++) {
+        long key;
+        if (i >= MQ_PREFILL && mq_delete_min(&mq, &rng, &key)) {
+            int rank = 0;
+            for (long k = key; k > 0; k -= k & -k) {
+                rank += fenwick[k];             // Keys below key sit at indices 1..key
+            }
+            ranks[i - MQ_PREFILL] = rank;
+            sum += rank;
+            for (long k = key + 1; k <= MQ_KEY_SPACE; k += k & -k) {
+                fenwick[k]--;
+            }
+        }
+        key = mq_random_key(&rng);
+        mq_insert(&mq, &rng, key);
+        for (long k = key + 1; k <= MQ_KEY_SPACE; k += k & -k) {
+            fenwick[k]++;
+        }
     }
     
-    // Re-insert with new priorities
-    for (int i = 0; i < count; i++) {
-        insert_ready_queue(&ready_queue, processes[i]);
+    qsort(ranks, pairs, sizeof(int), compare_int);
+    *mean = pairs > 0 ? (double)sum / pairs : 0.0;
+    *p99 = pairs > 0 ? ranks[(int)(0.99 * (pairs - 1))] : 0;
+    *max = pairs > 0 ? ranks[pairs - 1] : 0;
+    mq_free(&mq);
+    free(fenwick);
+    free(ranks);
+    return 0;
+}
+
+/**
+ * Compare one mutex-protected ready heap with a MultiQueue of
+ * MQ_HEAPS_PER_THREAD heaps per thread, at 1, 2, 4, ... threads
+ */
+int run_mq_bench(long pairs, int max_threads, uint64_t seed) {
+    printf("=== MultiQueue Benchmark ===\n");
+    printf("Ready set of %d, %ld delete-min/insert pairs per run, %d heaps per thread, "
+           "host CPUs %d\n", MQ_PREFILL, pairs, MQ_HEAPS_PER_THREAD, host_cpu_count());
+    printf("%-8s %6s %12s %12s %8s %10s %8s %8s\n", "Threads", "Heaps", "Locked Mops",
+           "MQ Mops", "Speedup", "Mean rank", "p99", "Max");
+    
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads) {
+            threads = max_threads;
+        }
+        int heaps = MQ_HEAPS_PER_THREAD * threads;
+        double locked = mq_throughput(1, threads, pairs, seed);
+        double relaxed = mq_throughput(heaps, threads, pairs, seed);
+        double mean;
+        int p99, max;
+        if (locked < 0 || relaxed < 0 || mq_rank_error(heaps, pairs, seed, &mean, &p99, &max) != 0) {
+            fprintf(stderr, "Error: MultiQueue benchmark ran out of memory\n");
+            return -1;
+        }
+        printf("%-8d %6d %12.2f %12.2f %7.2fx %10.2f %8d %8d\n", threads, heaps, locked,
+               relaxed, locked > 0 ? relaxed / locked : 0.0, mean, p99, max);
+        if (threads == max_threads) {
+            break;
+        }
     }
+    return 0;
 }
 
 /* ============================================================================
- * SCHEDULER
+ * PLUGIN BENCHMARK
  * ============================================================================ */
 
 /**
- * Main Scheduler Function
- * 
- * Implements Priority-SRTF non-preemptive scheduling:
- * 1. Check for arriving processes
- * 2. Update aging mechanism
- * 3. Select next process from ready queue (already sorted by Priority-SRTF)
- * 4. Run process for its interval_time (non-preemptive)
- * 5. Handle I/O or termination
+ * One timed run of the workload, through the plugin or the built-in policy
  */
-void run_scheduler() {
-    Process *running_process = NULL;
-    int running_until = 0;  // When current process will finish its burst
-    int last_aging_check = 0;  // Last time we checked aging
+typedef struct {
+    double wall;                    // Seconds, best of the runs
+    long calls;                     // Plugin callbacks per run
+    RunSummary summary;
+} PluginRun;
+
+static int plugin_bench_run(const Process *processes, int count, const SchedPlugin *plugin,
+                            uint64_t seed, PluginRun *out) {
+    SimContext ctx;
+    sim_init(&ctx, 0, 1);
+    ctx.plugin = plugin;
+    rng_seed(&ctx.rng, seed);
+    ctx.processes = malloc(sizeof(Process) * (count > 0 ? count : 1));
+    if (ctx.processes == NULL) {
+        perror("Error allocating benchmark run");
+        sim_destroy(&ctx);
+        return -1;
+    }
+    memcpy(ctx.processes, processes, sizeof(Process) * count);
+    ctx.total_processes = count;
     
-    while (1) {
-        pthread_mutex_lock(&clock_mutex);
-        current_clock++;
-        int clock = current_clock;
-        pthread_mutex_unlock(&clock_mutex);
-        
-        pthread_mutex_lock(&queue_mutex);
-        
-        // Check for new arrivals
-        for (int i = 0; i < total_processes; i++) {
-            if (!all_processes[i].has_arrived && 
-                all_processes[i].arrival_time <= clock) {
-                
-                all_processes[i].has_arrived = 1;
-                
-                pthread_mutex_lock(&output_mutex);
-                printf("[Clock: %d] PID %d arrived\n", clock, all_processes[i].pid);
-                fflush(stdout);
-                pthread_mutex_unlock(&output_mutex);
-                
-                all_processes[i].state = STATE_READY;
-                insert_ready_queue(&ready_queue, &all_processes[i]);
-                
-                pthread_mutex_lock(&output_mutex);
-                printf("[Clock: %d] PID %d moved to READY queue\n", 
-                       clock, all_processes[i].pid);
-                fflush(stdout);
-                pthread_mutex_unlock(&output_mutex);
-            }
-        }
-        
-        // Update aging every 1ms for processes in ready queue
-        if (clock > last_aging_check) {
-            int elapsed = clock - last_aging_check;
-            update_aging(elapsed);
-            resort_ready_queue();
-            last_aging_check = clock;
-        }
-        
-        // Check if current running process has finished its burst
-        if (running_process != NULL && clock >= running_until) {
-            // Process finished its interval burst
-            int burst_time = clock - (running_until - running_process->interval_time);
-            if (burst_time > running_process->remaining_time) {
-                burst_time = running_process->remaining_time;
-            }
-            
-            running_process->remaining_time -= burst_time;
-            
-            if (running_process->remaining_time <= 0) {
-                // Process terminated
-                running_process->state = STATE_TERMINATED;
-                
-                pthread_mutex_lock(&output_mutex);
-                printf("[Clock: %d] PID %d TERMINATED\n", clock, running_process->pid);
-                fflush(stdout);
-                pthread_mutex_unlock(&output_mutex);
-                
-                running_process = NULL;
-            } else {
-                // Process needs I/O
-                running_process->state = STATE_WAITING;
-                running_process->io_completion_time = clock + running_process->io_time;
-                
-                pthread_mutex_lock(&output_mutex);
-                printf("[Clock: %d] PID %d blocked for I/O for %d ms\n", 
-                       clock, running_process->pid, running_process->io_time);
-                fflush(stdout);
-                pthread_mutex_unlock(&output_mutex);
-                
-                enqueue(&waiting_queue, running_process);
-                running_process = NULL;
-            }
-        }
-        
-        // Schedule next process if CPU is idle
-        if (running_process == NULL && !is_empty(&ready_queue)) {
-            running_process = dequeue(&ready_queue);
-            running_process->state = STATE_RUNNING;
-            
-            // Calculate actual burst time (minimum of interval_time and remaining_time)
-            int burst_time = running_process->interval_time;
-            if (burst_time > running_process->remaining_time) {
-                burst_time = running_process->remaining_time;
-            }
-            
-            running_until = clock + burst_time;
-            
-            pthread_mutex_lock(&output_mutex);
-            printf("[Clock: %d] Scheduler dispatched PID %d (Pr: %d, Rm: %d) for %d ms burst\n",
-                   clock, running_process->pid, running_process->priority, 
-                   running_process->remaining_time, burst_time);
-            fflush(stdout);
-            pthread_mutex_unlock(&output_mutex);
-        }
-        
-        // Check if all processes are terminated
-        int all_done = 1;
-        for (int i = 0; i < total_processes; i++) {
-            if (all_processes[i].state != STATE_TERMINATED) {
-                all_done = 0;
-                break;
-            }
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    run_scheduler(&ctx);
+    gettimeofday(&end, NULL);
+    double wall = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    
+    int ok = ctx.all_terminated;        // Setup failures return before the first tick
+    if (ok) {
+        if (out->wall == 0.0 || wall < out->wall) {
+            out->wall = wall;
         }
-        
-        if (all_done && running_process == NULL) {
-            all_terminated = 1;
-            pthread_mutex_unlock(&queue_mutex);
-            break;
+        out->calls = ctx.plugin_calls;
+        compute_summary(&ctx, &out->summary);
+    }
+    sim_destroy(&ctx);
+    return ok ? 0 : -1;
+}
+
+/**
+ * Time the workload under the built-in srtf policy and under the plugin,
+ * alternating runs so both see the same machine state
+ */
+int run_plugin_bench(const Process *processes, int count, int runs, uint64_t seed) {
+    PluginRun builtin, plugin;
+    memset(&builtin, 0, sizeof(builtin));
+    memset(&plugin, 0, sizeof(plugin));
+    for (int r = 0; r < runs; r++) {
+        if (plugin_bench_run(processes, count, NULL, seed, &builtin) != 0 ||
+            plugin_bench_run(processes, count, policy_plugin, seed, &plugin) != 0) {
+            return -1;
         }
-        
-        pthread_mutex_unlock(&queue_mutex);
-        
-        usleep(1000);  // Sleep for 1ms
     }
+    
+    double extra = plugin.wall - builtin.wall;
+    printf("=== Policy Plugin Benchmark ===\n");
+    printf("Plugin: %s, processes: %d, cores: %d, best of %d run(s)\n", policy_plugin->name,
+           count, core_count, runs);
+    printf("%-10s %10s %12s\n", "Path", "Wall ms", "Callbacks");
+    printf("%-10s %10.3f %12s\n", "built-in", builtin.wall * 1e3, "-");
+    printf("%-10s %10.3f %12ld\n", "plugin", plugin.wall * 1e3, plugin.calls);
+    printf("Overhead: %.1f ns per callback, %+.1f%% run time\n",
+           plugin.calls > 0 ? extra * 1e9 / plugin.calls : 0.0,
+           builtin.wall > 0 ? 100.0 * extra / builtin.wall : 0.0);
+    printf("Results match built-in srtf: %s\n",
+           memcmp(builtin.summary.values, plugin.summary.values,
+                  sizeof(builtin.summary.values)) == 0 ? "yes" : "no");
+    return 0;
 }
 
 /* ============================================================================
  * MAIN FUNCTION
  * ============================================================================ */
 
+/**
+ * Print command line usage
+ */
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options] <input_file>\n", prog);
+    fprintf(stderr, "       %s [options] --generate SPEC\n", prog);
+    fprintf(stderr, "       %s [options] --batch DIR|GLOB\n", prog);
+    fprintf(stderr, "       %s [options] --mq-bench PAIRS\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --steady-state         Delete warm-up (MSER-5) and stop once CIs converge\n");
+    fprintf(stderr, "  --ci-width W           Target relative 95%% CI half-width (default 0.05)\n");
+    fprintf(stderr, "  --ci-metrics LIST      Metrics to converge: wait,turnaround (default wait)\n");
+    fprintf(stderr, "  --virtual-time         Run without sleeping; deterministic event order\n");
+    fprintf(stderr, "  --summary              Print run summary metrics\n");
+    fprintf(stderr, "  --generate SPEC        Synthetic workload, e.g. n=1000,iat=20,cpu=50,burst=10,io=5,prio=0-10\n");
+    fprintf(stderr, "  --seed S               Generator seed (default 1)\n");
+    fprintf(stderr, "  --replications R       Run R independent replications in parallel\n");
+    fprintf(stderr, "  --threads T            Worker threads (default: online CPUs)\n");
+    fprintf(stderr, "  --batch DIR|GLOB       Simulate every matching workload file in parallel\n");
+    fprintf(stderr, "  --out-dir DIR          Per-file batch summaries (default batch_summaries)\n");
+    fprintf(stderr, "  --estimate             Predict per-priority waits with M/G/1 formulas\n");
+    fprintf(stderr, "  --validate             With --estimate, compare against a simulation\n");
+    fprintf(stderr, "  --characterize         Profile the input in one streaming pass: arrival rate,\n");
+    fprintf(stderr, "                         size CDFs, offered load per priority, concurrency\n");
+    fprintf(stderr, "  --checkpoint-every MS  Checkpoint interval for --save-checkpoints/--resume (default 10000)\n");
+    fprintf(stderr, "  --save-checkpoints F   Simulate the input and write its checkpoints to F\n");
+    fprintf(stderr, "  --resume BASE          Re-simulate the input as an edit of BASE (checkpoint\n");
+    fprintf(stderr, "                         file or workload), stopping once state converges\n");
+    fprintf(stderr, "  --closed N[,N...]      Closed system of N users reusing the input as job shapes\n");
+    fprintf(stderr, "  --think MS             Mean exponential think time for --closed (default 1000)\n");
+    fprintf(stderr, "  --duration MS          Simulated length of each --closed run (default 600000)\n");
+    fprintf(stderr, "  --cores N              Simulated CPU cores, each with its own ready queue (default 1)\n");
+    fprintf(stderr, "  --dispatch LIST        Core choice for arrivals and I/O returns: rr,jsq,pod,lwl,sita\n");
+    fprintf(stderr, "                         or all (default jsq); several compare tail latency\n");
+    fprintf(stderr, "  --choices D            Cores sampled by the pod policy (default 2)\n");
+    fprintf(stderr, "  --policy P             Ready-queue order: srtf, gittins or fcfs (default srtf)\n");
+    fprintf(stderr, "  --size-prior FILE      Learn gittins indices from FILE's job sizes\n");
+    fprintf(stderr, "                         (default: the simulated workload)\n");
+    fprintf(stderr, "  --cgroup NAME:Q/P      CPU bandwidth group: Q ms per P ms for processes\n");
+    fprintf(stderr, "                         tagged group=NAME (repeatable)\n");
+    fprintf(stderr, "  --locks P              Protocol for res= resources: none, inherit or ceiling\n");
+    fprintf(stderr, "                         (default inherit)\n");
+    fprintf(stderr, "  --offline C@T[:T2]     Take core C offline at T ms, back online at T2 (repeatable)\n");
+    fprintf(stderr, "  --noise SPEC           Noise stealing CPU from running bursts (repeatable):\n");
+    fprintf(stderr, "                         periodic:PERIOD/DUR or poisson:MEAN/DUR ms, [@CORE]\n");
+    fprintf(stderr, "  --memory MB            Host memory for mem= working sets; bursts slow down when\n");
+    fprintf(stderr, "                         the resident set exceeds it\n");
+    fprintf(stderr, "  --thrash-penalty K     Cost of the paged share of a burst (default 10)\n");
+    fprintf(stderr, "  --mem-admit            Hold arrivals until their working set fits in memory\n");
+    fprintf(stderr, "  --smt FACTOR           Pair cores 2k/2k+1 as SMT siblings; bursts take FACTOR times\n");
+    fprintf(stderr, "                         longer while both are busy\n");
+    fprintf(stderr, "  --smt-place P          Tie-break for equally loaded cores: none, spread or pack\n");
+    fprintf(stderr, "  --freqs LIST           Core frequency levels in MHz (e.g. 2400,1800,1200)\n");
+    fprintf(stderr, "  --governor G           DVFS governor: performance, powersave or ondemand\n");
+    fprintf(stderr, "                         (default performance)\n");
+    fprintf(stderr, "  --governor-window MS   Ondemand evaluation period (default 20)\n");
+    fprintf(stderr, "  --power A/I            Core watts busy at the top frequency / idle (default 10/1)\n");
+    fprintf(stderr, "  --cstates LIST         Core idle states NAME:RESIDENCY/EXIT ms, shallowest first\n");
+    fprintf(stderr, "                         (e.g. C1:0/1,C3:20/10,C6:200/50)\n");
+    fprintf(stderr, "  --nodes N              Simulate a cluster of N nodes with --cores cores each;\n");
+    fprintf(stderr, "                         a global dispatcher routes arrivals to nodes\n");
+    fprintf(stderr, "  --placement P          Cluster placement: jsq, lwl, pod, rr or random (default jsq)\n");
+    fprintf(stderr, "  --sync-window MS       Simulated time nodes run between routing rounds (default 10)\n");
+    fprintf(stderr, "  --lock-memory          mlockall and prefault tables, stacks and the log buffer\n");
+    fprintf(stderr, "                         before the run; report page faults taken during it\n");
+    fprintf(stderr, "  --sched-fifo PRIO      With --lock-memory, run the scheduler thread SCHED_FIFO\n");
+    fprintf(stderr, "  --policy-plugin SO     Take ready-queue order from a shared object implementing\n");
+    fprintf(stderr, "                         scheduler_plugin.h instead of --policy\n");
+    fprintf(stderr, "  --plugin-bench RUNS    Time the plugin against built-in srtf on the workload\n");
+    fprintf(stderr, "  --hooks SO             Load lifecycle hooks (scheduler_plugin.h) for custom\n");
+    fprintf(stderr, "                         metrics; repeatable\n");
+    fprintf(stderr, "  --mq-bench PAIRS       Benchmark a relaxed MultiQueue ready set against one locked\n");
+    fprintf(stderr, "                         heap at 1, 2, 4, ... --threads; reports rank error\n");
+    fprintf(stderr, "  --backfill             Let smaller jobs start ahead of a waiting threads= gang\n");
+    fprintf(stderr, "                         job if they do not delay it (EASY backfilling)\n");
+}
+
 int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        { "steady-state", no_argument,       NULL, 's' },
+        { "ci-width",     required_argument, NULL, 'w' },
+        { "ci-metrics",   required_argument, NULL, 'm' },
+        { "virtual-time", no_argument,       NULL, 'v' },
+        { "summary",      no_argument,       NULL, 'S' },
+        { "generate",     required_argument, NULL, 'g' },
+        { "seed",         required_argument, NULL, 'r' },
+        { "replications", required_argument, NULL, 'R' },
+        { "threads",      required_argument, NULL, 'T' },
+        { "batch",        required_argument, NULL, 'b' },
+        { "out-dir",      required_argument, NULL, 'o' },
+        { "estimate",     no_argument,       NULL, 'e' },
+        { "validate",     no_argument,       NULL, 'V' },
+        { "characterize", no_argument,       NULL, 'q' },
+        { "checkpoint-every", required_argument, NULL, 'k' },
+        { "save-checkpoints", required_argument, NULL, 'K' },
+        { "resume",       required_argument, NULL, 'u' },
+        { "closed",       required_argument, NULL, 'c' },
+        { "think",        required_argument, NULL, 't' },
+        { "duration",     required_argument, NULL, 'd' },
+        { "cores",        required_argument, NULL, 'C' },
+        { "dispatch",     required_argument, NULL, 'D' },
+        { "choices",      required_argument, NULL, 'x' },
+        { "policy",       required_argument, NULL, 'P' },
+        { "size-prior",   required_argument, NULL, 'z' },
+        { "cgroup",       required_argument, NULL, 'G' },
+        { "locks",        required_argument, NULL, 'L' },
+        { "backfill",     no_argument,       NULL, 'B' },
+        { "offline",      required_argument, NULL, 'O' },
+        { "cstates",      required_argument, NULL, 'E' },
+        { "freqs",        required_argument, NULL, 'F' },
+        { "smt",          required_argument, NULL, 'M' },
+        { "noise",        required_argument, NULL, 'Q' },
+        { "memory",       required_argument, NULL, 'U' },
+        { "thrash-penalty", required_argument, NULL, 'X' },
+        { "mem-admit",    no_argument,       NULL, 'A' },
+        { "smt-place",    required_argument, NULL, 'N' },
+        { "governor",     required_argument, NULL, 'H' },
+        { "governor-window", required_argument, NULL, 'W' },
+        { "power",        required_argument, NULL, 'Y' },
+        { "nodes",        required_argument, NULL, 'n' },
+        { "placement",    required_argument, NULL, 'p' },
+        { "sync-window",  required_argument, NULL, 'i' },
+        { "mq-bench",     required_argument, NULL, 'j' },
+        { "lock-memory",  no_argument,       NULL, 'l' },
+        { "sched-fifo",   required_argument, NULL, 'f' },
+        { "policy-plugin", required_argument, NULL, 'a' },
+        { "plugin-bench", required_argument, NULL, 'y' },
+        { "hooks",        required_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    
+    int virtual_time = 0;
+    int show_summary = 0;
+    const char *generate_spec = NULL;
+    uint64_t seed = 1;
+    int replications = 0;
+    int threads = host_cpu_count();
+    const char *batch_pattern = NULL;
+    const char *out_dir = "batch_summaries";
+    int estimate = 0;
+    int validate = 0;
+    int characterize = 0;
+    int checkpoint_interval = 10000;
+    const char *checkpoint_file = NULL;
+    const char *resume_base = NULL;
+    const char *closed_list = NULL;
+    double think_mean = 1000.0;
+    int duration = 600000;
+    unsigned dispatch_mask = 0;
+    const char *size_prior = NULL;
+    long mq_pairs = 0;
+    const char *plugin_path = NULL;
+    int plugin_runs = 0;
+    
+    // Parse command line options
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's':
+                steady_state_enabled = 1;
+                break;
+            case 'w':
+                ci_target_width = atof(optarg);
+                if (ci_target_width <= 0.0) {
+                    fprintf(stderr, "Error: --ci-width must be positive\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'm':
+                steady_metric_mask = parse_steady_metrics(optarg);
+                if (steady_metric_mask == 0) {
+                    fprintf(stderr, "Error: Unknown metric in --ci-metrics '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'v':
+                virtual_time = 1;
+                break;
+            case 'S':
+                show_summary = 1;
+                break;
+            case 'g':
+                generate_spec = optarg;
+                break;
+            case 'r':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'R':
+                replications = atoi(optarg);
+                if (replications < 1) {
+                    fprintf(stderr, "Error: --replications must be at least 1\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'T':
+                threads = atoi(optarg);
+                if (threads < 1) {
+                    fprintf(stderr, "Error: --threads must be at least 1\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'b':
+                batch_pattern = optarg;
+                break;
+            case 'o':
+                out_dir = optarg;
+                break;
+            case 'e':
+                estimate = 1;
+                break;
+            case 'V':
+                validate = 1;
+                break;
+            case 'q':
+                characterize = 1;
+                break;
+            case 'k':
+                checkpoint_interval = atoi(optarg);
+                if (checkpoint_interval < 1) {
+                    fprintf(stderr, "Error: --checkpoint-every must be at least 1\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'K':
+                checkpoint_file = optarg;
+                break;
+            case 'u':
+                resume_base = optarg;
+                break;
+            case 'c':
+                closed_list = optarg;
+                break;
+            case 't':
+                think_mean = atof(optarg);
+                if (think_mean < 0.0) {
+                    fprintf(stderr, "Error: --think must not be negative\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                if (duration < 1) {
+                    fprintf(stderr, "Error: --duration must be at least 1\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'C':
+                core_count = atoi(optarg);
+                if (core_count < 1 || core_count > MAX_CORES) {
+                    fprintf(stderr, "Error: --cores must be between 1 and %d\n", MAX_CORES);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'D':
+                dispatch_mask = parse_dispatch_policies(optarg);
+                if (dispatch_mask == 0) {
+                    fprintf(stderr, "Error: Unknown policy in --dispatch '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'x':
+                dispatch_choices = atoi(optarg);
+                if (dispatch_choices < 1) {
+                    fprintf(stderr, "Error: --choices must be at least 1\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'P':
+                for (sched_policy = 0; sched_policy < NUM_SCHED_POLICIES; sched_policy++) {
+                    if (strcmp(optarg, sched_policy_names[sched_policy]) == 0) {
+                        break;
+                    }
+                }
+                if (sched_policy == NUM_SCHED_POLICIES) {
+                    fprintf(stderr, "Error: Unknown --policy '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'z':
+                size_prior = optarg;
+                break;
+            case 'L':
+                for (lock_protocol = 0; lock_protocol < NUM_LOCK_PROTOCOLS; lock_protocol++) {
+                    if (strcmp(optarg, lock_protocol_names[lock_protocol]) == 0) {
+                        break;
+                    }
+                }
+                if (lock_protocol == NUM_LOCK_PROTOCOLS) {
+                    fprintf(stderr, "Error: Unknown --locks protocol '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'B':
+                gang_backfill = 1;
+                break;
+            case 'n':
+                cluster_nodes = atoi(optarg);
+                if (cluster_nodes < 1) {
+                    fprintf(stderr, "Error: --nodes must be at least 1\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                for (cluster_placement = 0; cluster_placement < NUM_PLACEMENTS; cluster_placement++) {
+                    if (strcmp(optarg, placements[cluster_placement].name) == 0) {
+                        break;
+                    }
+                }
+                if (cluster_placement == NUM_PLACEMENTS) {
+                    fprintf(stderr, "Error: Unknown --placement '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'l':
+                lock_memory = 1;
+                break;
+            case 'a':
+                plugin_path = optarg;
+                break;
+            case 'h':
+                if (hooks_load(optarg) != 0) {
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'y':
+                plugin_runs = atoi(optarg);
+                if (plugin_runs < 1) {
+                    fprintf(stderr, "Error: --plugin-bench needs at least 1 run\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'f':
+                fifo_priority = atoi(optarg);
+                if (fifo_priority < sched_get_priority_min(SCHED_FIFO) ||
+                    fifo_priority > sched_get_priority_max(SCHED_FIFO)) {
+                    fprintf(stderr, "Error: --sched-fifo priority must be between %d and %d\n",
+                            sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'j':
+                mq_pairs = atol(optarg);
+                if (mq_pairs < 1) {
+                    fprintf(stderr, "Error: --mq-bench needs at least 1 operation pair\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'i':
+                cluster_window = atoi(optarg);
+                if (cluster_window < 1) {
+                    fprintf(stderr, "Error: --sync-window must be at least 1 ms\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'U':
+                memory_capacity = atol(optarg);
+                if (memory_capacity < 1) {
+                    fprintf(stderr, "Error: --memory must be at least 1 MB\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'X':
+                thrash_penalty = atof(optarg);
+                if (thrash_penalty < 0) {
+                    fprintf(stderr, "Error: --thrash-penalty cannot be negative\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'A':
+                mem_admission = 1;
+                break;
+            case 'Q':
+                if (parse_noise_spec(optarg) != 0) {
+                    fprintf(stderr, "Error: Invalid --noise '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'M':
+                smt_factor = atof(optarg);
+                if (smt_factor < 1.0) {
+                    fprintf(stderr, "Error: --smt slowdown must be at least 1.0\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'N':
+                for (smt_place = 0; smt_place < NUM_SMT_PLACEMENTS; smt_place++) {
+                    if (strcmp(optarg, smt_place_names[smt_place]) == 0) {
+                        break;
+                    }
+                }
+                if (smt_place == NUM_SMT_PLACEMENTS) {
+                    fprintf(stderr, "Error: Unknown --smt-place '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'F':
+                if (parse_freqs(optarg) != 0) {
+                    fprintf(stderr, "Error: Invalid --freqs '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'H':
+                for (governor = 0; governor < NUM_GOVERNORS; governor++) {
+                    if (strcmp(optarg, governor_names[governor]) == 0) {
+                        break;
+                    }
+                }
+                if (governor == NUM_GOVERNORS) {
+                    fprintf(stderr, "Error: Unknown --governor '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'W':
+                governor_window = atoi(optarg);
+                if (governor_window < 1) {
+                    fprintf(stderr, "Error: --governor-window must be at least 1 ms\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'Y': {
+                char extra;
+                if (sscanf(optarg, "%lf/%lf%c", &active_watts, &idle_watts, &extra) != 2 ||
+                    idle_watts < 0 || active_watts < idle_watts) {
+                    fprintf(stderr, "Error: Invalid --power '%s' (ACTIVE/IDLE watts)\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+            case 'E':
+                if (parse_cstates(optarg) != 0) {
+                    fprintf(stderr, "Error: Invalid --cstates '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'O':
+                if (parse_core_event(optarg) != 0) {
+                    fprintf(stderr, "Error: Invalid --offline '%s' (CORE@FROM[:TO])\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'G':
+                if (parse_group_spec(optarg) != 0) {
+                    fprintf(stderr, "Error: Invalid or duplicate --cgroup '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    
+    // A single policy applies to every run; several are compared side by side
+    int compare_dispatch = dispatch_mask & (dispatch_mask - 1);
+    for (int i = 0; i < NUM_DISPATCH_POLICIES; i++) {
+        if (dispatch_mask == 1u << i) {
+            dispatch_policy = i;
+        }
+    }
+    
+    if (plugin_path != NULL) {
+        if (sched_policy != POLICY_SRTF || core_event_count > 0) {
+            fprintf(stderr, "Error: --policy-plugin replaces --policy and cannot be used with\n"
+                            "       --offline\n");
+            return EXIT_FAILURE;
+        }
+        policy_plugin = plugin_load(plugin_path);
+        if (policy_plugin == NULL) {
+            return EXIT_FAILURE;
+        }
+    } else if (plugin_runs > 0) {
+        fprintf(stderr, "Error: --plugin-bench requires --policy-plugin\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (validate && !estimate) {
+        fprintf(stderr, "Error: --validate requires --estimate\n");
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (estimate && core_count > 1) {
+        // The M/G/1 formulas model one server; a validation run must match
+        fprintf(stderr, "Error: --estimate models a single core; drop --cores\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (size_prior != NULL) {
+        gittins_prior = load_size_prior(size_prior);
+        if (gittins_prior == NULL) {
+            return EXIT_FAILURE;
+        }
+    }
+    
+    if (batch_pattern != NULL) {
+        if (argc - optind != 0) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        return run_batch(batch_pattern, out_dir, threads) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (mq_pairs > 0) {
+        if (argc - optind != 0) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        return run_mq_bench(mq_pairs, threads, seed) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
     // Check command line arguments
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
+    int inputs = argc - optind;
+    if ((generate_spec == NULL && inputs != 1) || (generate_spec != NULL && inputs != 0)) {
+        print_usage(argv[0]);
         return EXIT_FAILURE;
     }
     
-    // Parse input file
-    if (parse_input_file(argv[1]) != 0) {
+    WorkloadSpec spec;
+    if (generate_spec != NULL && parse_workload_spec(generate_spec, &spec) != 0) {
+        fprintf(stderr, "Error: Invalid --generate spec '%s'\n", generate_spec);
         return EXIT_FAILURE;
     }
     
-    // Initialize queues
-    init_queue(&ready_queue);
-    init_queue(&waiting_queue);
+    for (int i = 0; i < noise_count; i++) {
+        if (noise_sources[i].core >= core_count) {
+            fprintf(stderr, "Error: --noise core %d needs --cores %d or more\n",
+                    noise_sources[i].core, noise_sources[i].core + 1);
+            return EXIT_FAILURE;
+        }
+    }
+    for (int i = 0; i < core_event_count; i++) {
+        if (core_events[i].core >= core_count) {
+            fprintf(stderr, "Error: --offline core %d needs --cores %d or more\n",
+                    core_events[i].core, core_events[i].core + 1);
+            return EXIT_FAILURE;
+        }
+    }
     
-    // Create I/O manager thread
-    pthread_t io_thread;
-    if (pthread_create(&io_thread, NULL, io_manager_thread, NULL) != 0) {
-        perror("Error creating I/O manager thread");
-        free(all_processes);
+    if (estimate) {
+        if (generate_spec != NULL) {
+            fprintf(stderr, "Error: --estimate requires an input file\n");
+            return EXIT_FAILURE;
+        }
+        return run_estimate(argv[optind], validate) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (characterize) {
+        if (generate_spec != NULL) {
+            fprintf(stderr, "Error: --characterize requires an input file\n");
+            return EXIT_FAILURE;
+        }
+        return run_characterize(argv[optind]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (checkpoint_file != NULL || resume_base != NULL) {
+        if (generate_spec != NULL || steady_state_enabled || core_count > 1 ||
+            sched_policy != POLICY_SRTF || group_count > 0 || core_event_count > 0 ||
+            cstate_count > 0 || freq_count > 0 || smt_factor > 0 || noise_count > 0 ||
+            memory_capacity > 0 || cluster_nodes > 0 || policy_plugin != NULL) {
+            fprintf(stderr, "Error: Checkpoints need an input file, one srtf core, no groups, no\n"
+                            "       --offline, --cstates, --freqs, --smt, --noise, --memory,\n"
+                            "       --nodes or --policy-plugin and no --steady-state\n");
+            return EXIT_FAILURE;
+        }
+        int rc = checkpoint_file != NULL
+                 ? run_save_checkpoints(argv[optind], checkpoint_file, checkpoint_interval)
+                 : run_incremental(argv[optind], resume_base, checkpoint_interval);
+        return rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (plugin_runs > 0) {
+        SimContext shared;
+        sim_init(&shared, 0, 1);
+        Rng rng;
+        rng_seed(&rng, seed);
+        int rc = generate_spec != NULL ? generate_workload(&shared, &spec, &rng)
+                                       : parse_input_file(&shared, argv[optind]);
+        if (rc == 0) {
+            rc = run_plugin_bench(shared.processes, shared.total_processes, plugin_runs, seed);
+        }
+        sim_destroy(&shared);
+        return rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (cluster_nodes > 0) {
+        if (closed_list != NULL || compare_dispatch || replications > 0 ||
+            steady_state_enabled || sched_policy != POLICY_SRTF) {
+            fprintf(stderr, "Error: --nodes needs --policy srtf and cannot be combined with\n"
+                            "       --closed, --replications, --steady-state or several\n"
+                            "       --dispatch policies\n");
+            return EXIT_FAILURE;
+        }
+        SimContext shared;
+        sim_init(&shared, 0, 1);
+        Rng rng;
+        rng_seed(&rng, seed);
+        int rc = generate_spec != NULL ? generate_workload(&shared, &spec, &rng)
+                                       : parse_input_file(&shared, argv[optind]);
+        if (rc == 0) {
+            rc = run_cluster(shared.processes, shared.total_processes, threads, seed,
+                             show_summary);
+        }
+        if (rc == 0) {
+            hooks_report();
+        }
+        sim_destroy(&shared);
+        return rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (closed_list != NULL) {
+        int *populations;
+        int runs = parse_populations(closed_list, &populations);
+        if (runs < 0) {
+            fprintf(stderr, "Error: Invalid --closed population list '%s'\n", closed_list);
+            return EXIT_FAILURE;
+        }
+        
+        // The workload only supplies job shapes; arrival times are ignored
+        SimContext shapes;
+        sim_init(&shapes, 0, 1);
+        Rng rng;
+        rng_seed(&rng, seed);
+        int rc = generate_spec != NULL ? generate_workload(&shapes, &spec, &rng)
+                                       : parse_input_file(&shapes, argv[optind]);
+        if (rc == 0) {
+            rc = run_closed_sweep(shapes.processes, shapes.total_processes, populations, runs,
+                                  think_mean, duration, threads, seed);
+        }
+        sim_destroy(&shapes);
+        free(populations);
+        return rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (compare_dispatch) {
+        SimContext shared;
+        sim_init(&shared, 0, 1);
+        Rng rng;
+        rng_seed(&rng, seed);
+        int rc = generate_spec != NULL ? generate_workload(&shared, &spec, &rng)
+                                       : parse_input_file(&shared, argv[optind]);
+        if (rc == 0) {
+            rc = run_dispatch_comparison(shared.processes, shared.total_processes,
+                                         dispatch_mask, threads, seed);
+        }
+        sim_destroy(&shared);
+        return rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (replications > 0) {
+        if (generate_spec == NULL) {
+            fprintf(stderr, "Error: --replications requires --generate\n");
+            return EXIT_FAILURE;
+        }
+        return run_replications(&spec, replications, threads, seed) == 0
+               ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (fifo_priority > 0 && !lock_memory) {
+        fprintf(stderr, "Error: --sched-fifo requires --lock-memory\n");
         return EXIT_FAILURE;
     }
+    if (lock_memory) {
+        // Install the log buffer before anything is printed
+        setvbuf(stdout, log_buffer, isatty(STDOUT_FILENO) ? _IOLBF : _IOFBF, sizeof(log_buffer));
+    }
     
-    // Run scheduler in main thread
-    run_scheduler();
+    SimContext sim;
+    sim_init(&sim, !virtual_time, 0);
+    sim.lock_memory = lock_memory;
+    sim.fifo_priority = fifo_priority;
+    rng_seed(&sim.rng, seed);
     
-    // Wait for I/O thread to finish
-    if (pthread_join(io_thread, NULL) != 0) {
-        perror("Error joining I/O manager thread");
+    // Load processes from the input file or the generator
+    if (generate_spec != NULL) {
+        Rng rng = sim.rng;
+        rng_jump(&sim.rng);             // Keep dispatch draws off the generator stream
+        if (generate_workload(&sim, &spec, &rng) != 0) {
+            sim_destroy(&sim);
+            return EXIT_FAILURE;
+        }
+    } else if (parse_input_file(&sim, argv[optind]) != 0) {
+        sim_destroy(&sim);
+        return EXIT_FAILURE;
+    }
+    
+    if (run_simulation(&sim) != 0) {
+        sim_destroy(&sim);
+        return EXIT_FAILURE;
+    }
+    
+    if (steady_state_enabled) {
+        print_steady_state_report(&sim);
     }
+    if (group_count > 0) {
+        print_group_report(&sim);
+    }
+    if (resource_count > 0) {
+        print_resource_report(&sim);
+    }
+    if (sim.segment_count > 1) {
+        print_capacity_report(&sim);
+    }
+    if (cstate_count > 0) {
+        print_cstate_report(&sim);
+    }
+    if (freq_count > 0) {
+        print_dvfs_report(&sim);
+    }
+    if (sim.smt_factor > 0 && sim.num_cores > 1) {
+        print_smt_report(&sim);
+    }
+    if (noise_count > 0) {
+        print_noise_report(&sim);
+    }
+    if (memory_capacity > 0) {
+        print_memory_report(&sim);
+    }
+    if (sim.pool_size > 0) {
+        print_thread_report(&sim);
+    }
+    if (sim.aio_issued > 0) {
+        print_aio_report(&sim);
+    }
+    if (sim.lock_memory) {
+        print_fault_report(&sim);
+    }
+    for (int k = 2; k <= sim.num_cores; k++) {
+        if (sim.gang_jobs[k] > 0) {
+            print_gang_report(&sim);
+            break;
+        }
+    }
+    if (show_summary) {
+        RunSummary summary;
+        compute_summary(&sim, &summary);
+        print_summary(stdout, &summary);
+    }
+    hooks_report();
     
     // Cleanup
-    free(all_processes);
-    pthread_mutex_destroy(&queue_mutex);
-    pthread_mutex_destroy(&clock_mutex);
+    sim_destroy(&sim);
     pthread_mutex_destroy(&output_mutex);
     
     return EXIT_SUCCESS;
 }
-
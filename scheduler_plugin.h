@@ -0,0 +1,128 @@
+/*
+ * scheduler_plugin.h
+ *
+ * Stable C ABI for ready-queue policies loaded with --policy-plugin and
+ * lifecycle hooks loaded with --hooks
+ *
+ * A plugin is a shared object exporting sched_plugin_entry(), which returns
+ * a SchedPlugin table. The simulator calls init once per run and then hands
+ * the plugin every process that becomes ready on a core; the plugin owns the
+ * per-core ready queues and picks the next process when a core is free.
+ * Core choice (--dispatch), I/O, groups and accounting stay in the simulator.
+ *
+ * Build a plugin with:
+ *   gcc -shared -fPIC -I. -o my_policy.so my_policy.c
+ *
+ * Rules:
+ * - Fields of SchedTask are read-only except priority and slots.
+ * - A priority written by the plugin takes effect when the task is picked.
+ * - pick_next is only called for a core that has at least one queued task.
+ * - Callbacks of one run never overlap: the simulator makes every call
+ *   with its queue mutex held, so the plugin's state needs no locking.
+ *   They do not all come from one thread, though: in real-time runs the
+ *   I/O thread calls enqueue for a process whose I/O completed. Do not
+ *   keep per-run data in thread-local storage.
+ * - Runs executing in parallel each get their own state from init.
+ *
+ * A hook library exports sched_hooks_entry(), returning a SchedHooks table.
+ * Its attach callback registers functions for the lifecycle events it wants;
+ * events nobody registered for cost the simulator a single mask test.
+ * Hooks get a read-only copy of the process and must not keep the pointer.
+ * With --replications, --nodes or other parallel modes they may be called
+ * from several threads at once. In real-time runs io_end fires on the I/O
+ * thread.
+ *
+ */
+
+#ifndef SCHEDULER_PLUGIN_H
+#define SCHEDULER_PLUGIN_H
+
+#include <stdint.h>
+
+#define SCHED_PLUGIN_ABI_VERSION 1
+#define SCHED_PLUGIN_SLOTS 4            // Private words per process
+#define SCHED_PLUGIN_ENTRY "sched_plugin_entry"
+
+/**
+ * A process as the plugin sees it
+ * Refreshed by the simulator before every callback that passes it.
+ */
+typedef struct SchedTask {
+    int pid;
+    int priority;                   // Current priority (0 = highest), writable
+    int original_priority;
+    int cpu_execution_time;         // Total CPU time needed (ms)
+    int remaining_time;             // CPU time still needed (ms)
+    int interval_time;              // Burst length (ms)
+    int io_time;                    // I/O time after each burst (ms)
+    int arrival_clock;
+    int ready_since;                // Clock at which it last became ready
+    int total_wait;                 // Time spent ready so far (ms)
+    uintptr_t slots[SCHED_PLUGIN_SLOTS];    // Plugin's own storage, zero at arrival
+} SchedTask;
+
+/**
+ * Policy callbacks; on_tick, on_block, on_exit and fini may be NULL
+ */
+typedef struct SchedPlugin {
+    uint32_t abi_version;           // SCHED_PLUGIN_ABI_VERSION
+    const char *name;
+
+    /** Per-run state for a machine of cores cores; NULL fails the run */
+    void *(*init)(int cores);
+    void (*fini)(void *state);
+
+    /** Task became ready on core */
+    void (*enqueue)(void *state, int core, SchedTask *task, int clock);
+
+    /** Remove and return the task core runs next */
+    SchedTask *(*pick_next)(void *state, int core, int clock);
+
+    /** Time advanced by elapsed ms (idle stretches arrive as one call) */
+    void (*on_tick)(void *state, int clock, int elapsed);
+
+    /** Task finished a burst and blocked for I/O */
+    void (*on_block)(void *state, SchedTask *task, int clock);
+
+    /** Task terminated */
+    void (*on_exit)(void *state, SchedTask *task, int clock);
+} SchedPlugin;
+
+typedef const SchedPlugin *(*SchedPluginEntry)(void);
+
+#define SCHED_HOOKS_ABI_VERSION 1
+#define SCHED_HOOKS_ENTRY "sched_hooks_entry"
+
+/**
+ * Lifecycle events a hook can observe
+ */
+typedef enum {
+    SCHED_HOOK_ARRIVAL,             // Process arrived (before any memory hold)
+    SCHED_HOOK_DISPATCH,            // Burst starts on a core
+    SCHED_HOOK_BURST_END,           // Burst finished; remaining_time is updated
+    SCHED_HOOK_IO_START,            // Blocked: I/O, a full async ring or a final drain
+    SCHED_HOOK_IO_END,              // Left the waiting queue
+    SCHED_HOOK_AGING,               // Aging raised the priority of a waiting process
+    SCHED_HOOK_TERMINATE,           // Process (or closed-system job) finished
+    SCHED_NUM_HOOKS
+} SchedHookEvent;
+
+typedef void (*SchedHook)(SchedHookEvent event, const SchedTask *task, int clock, void *arg);
+
+/** Register hook for event; returns -1 if the registry is full */
+typedef int (*SchedHookRegister)(SchedHookEvent event, SchedHook hook, void *arg);
+
+typedef struct SchedHooks {
+    uint32_t abi_version;           // SCHED_HOOKS_ABI_VERSION
+    const char *name;
+
+    /** Register hooks once at load; non-zero fails the load */
+    int (*attach)(SchedHookRegister register_hook);
+
+    /** Print results after the run's reports; may be NULL */
+    void (*report)(void);
+} SchedHooks;
+
+typedef const SchedHooks *(*SchedHooksEntry)(void);
+
+#endif